@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * @file    bench_batching.c
+ * @brief   Publication batching throughput benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Publishes control cycles of small ros_Imu, ros_JointState and
+ *          ros_BatteryState messages without batching, with a manual batch per
+ *          cycle and with automatic batching. Transport send syscalls are
+ *          counted by wrapping send() and sendto(), each one carries a frame.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+static volatile uint64_t syscalls;
+static volatile uint64_t sent_bytes;
+
+ssize_t __real_send(int fd, const void* buf, size_t len, int flags);
+ssize_t __real_sendto(int fd, const void* buf, size_t len, int flags, const struct sockaddr* addr, socklen_t alen);
+
+ssize_t __wrap_send(int fd, const void* buf, size_t len, int flags){
+    __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sent_bytes, len, __ATOMIC_RELAXED);
+    return __real_send(fd, buf, len, flags);
+}
+
+ssize_t __wrap_sendto(int fd, const void* buf, size_t len, int flags, const struct sockaddr* addr, socklen_t alen){
+    __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sent_bytes, len, __ATOMIC_RELAXED);
+    return __real_sendto(fd, buf, len, flags, addr, alen);
+}
+
+static bench_args_t args = {
+    .ifx = {
+        .mode = "client",
+        .locator = "tcp/127.0.0.1:7447",
+    },
+    .count = 1000,      // control cycles
+    .depth = 8,         // messages of each type per cycle
+    .period_us = 1000,  // control cycle period
+};
+
+static picoros_node_t node = {
+    .name = "bench_batching",
+};
+
+#define BENCH_PUB(NAME, TYPE) {                 \
+        .topic = {                              \
+            .name = NAME,                       \
+            .type = ROSTYPE_NAME(TYPE),         \
+            .rihs_hash = ROSTYPE_HASH(TYPE),    \
+        },                                      \
+    }
+static picoros_publisher_t pub_imu = BENCH_PUB("bench/imu", ros_Imu);
+static picoros_publisher_t pub_joints = BENCH_PUB("bench/joint_states", ros_JointState);
+static picoros_publisher_t pub_battery = BENCH_PUB("bench/battery_state", ros_BatteryState);
+
+static uint8_t pub_buf[1024];
+
+static void publish_cycle(uint32_t cycle){
+    size_t len;
+    ros_Imu imu = {.header = {.frame_id = "imu", .stamp.sec = cycle}};
+    double pos[6] = {0};
+    ros_JointState joints = {
+        .header = {.frame_id = "base", .stamp.sec = cycle},
+        .name = {.data = (char*[]){"j0", "j1", "j2", "j3", "j4", "j5"}, .n_elements = 6},
+        .position = {.data = pos, .n_elements = 6},
+    };
+    ros_BatteryState bat = {.header = {.stamp.sec = cycle}, .location = "main", .serial_number = "0"};
+
+    for (uint32_t i = 0; i < args.depth; i++){
+        len = ps_serialize(pub_buf, &imu, sizeof(pub_buf));
+        picoros_publish(&pub_imu, pub_buf, len);
+        len = ps_serialize(pub_buf, &joints, sizeof(pub_buf));
+        picoros_publish(&pub_joints, pub_buf, len);
+        len = ps_serialize(pub_buf, &bat, sizeof(pub_buf));
+        picoros_publish(&pub_battery, pub_buf, len);
+    }
+}
+
+static void run(const char* mode){
+    uint64_t start_sys = syscalls;
+    uint64_t start_bytes = sent_bytes;
+    uint64_t start_cpu = bench_cpu_ns();
+    uint64_t start = bench_now_ns();
+    bool manual = strcmp(mode, "manual") == 0;
+
+    for (uint32_t c = 0; c < args.count; c++){
+        if (manual){
+            picoros_batch_begin();
+        }
+        publish_cycle(c);
+        if (manual){
+            picoros_batch_flush();
+        }
+        z_sleep_us(args.period_us);
+    }
+    picoros_batch_auto(NULL);
+
+    uint64_t msgs = (uint64_t)args.count * args.depth * 3;
+    uint64_t sys = syscalls - start_sys;
+    double elapsed_s = (double)(bench_now_ns() - start) / 1e9;
+    bench_csv_row("batching", "%s,%" PRIu64 ",%" PRIu64 ",%.3f,%.1f,%.1f,%.0f",
+                  mode, msgs, sys, (double)sys / msgs,
+                  (double)(sent_bytes - start_bytes) / msgs,
+                  (double)(bench_cpu_ns() - start_cpu) / msgs,
+                  msgs / elapsed_s);
+}
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    bench_interface_init(&args);
+    picoros_node_init(&node);
+    picoros_publisher_declare(&node, &pub_imu);
+    picoros_publisher_declare(&node, &pub_joints);
+    picoros_publisher_declare(&node, &pub_battery);
+
+    bench_csv_header("mode,messages,syscalls,syscalls_per_msg,wire_bytes_per_msg,cpu_ns_per_msg,msgs_per_s");
+    run("none");
+    run("manual");
+    picoros_batch_cfg_t cfg = {
+        .max_bytes = args.size ? args.size : 4096,
+        .max_latency_us = args.period_us / 2,
+    };
+    picoros_batch_auto(&cfg);
+    run("auto");
+    return 0;
+}
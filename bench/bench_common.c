@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * @file    bench_common.c
+ * @brief   Common utilities for picoros benchmarks
+ * @date    2026-Oct-18
+ *
+ * @details Benchmarks link picoalloc, so every heap allocation made through
+ *          zenoh-pico platform layer by picoros and zenoh-pico is counted.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench_common.h"
+
+int bench_parse_args(int argc, char** argv, bench_args_t* args){
+    int opt;
+    while ((opt = getopt(argc, argv, "a:m:r:t:s:n:d:p:P:S:T:x:zh")) != -1) {
+        switch (opt) {
+            case 'a': args->ifx.locator = optarg; break;
+            case 'm': args->ifx.mode = optarg; break;
+            case 'r': args->role = optarg; break;
+            case 't': args->type = optarg; break;
+            case 's': args->size = strtoul(optarg, NULL, 0); break;
+            case 'n': args->count = strtoul(optarg, NULL, 0); break;
+            case 'd': args->depth = strtoul(optarg, NULL, 0); break;
+            case 'p': args->period_us = strtoul(optarg, NULL, 0); break;
+            case 'P': args->publishers = strtoul(optarg, NULL, 0); break;
+            case 'S': args->subscribers = strtoul(optarg, NULL, 0); break;
+            case 'T': args->threads = strtoul(optarg, NULL, 0); break;
+            case 'x': args->sessions = strtoul(optarg, NULL, 0); break;
+            case 'z': args->variant = true; break;
+            case 'h':
+            default:
+                fprintf(stderr,
+                    "-m 'mode' ['client', 'peer']\n"
+                    "-a 'address' to connect or listen on (ex: 'tcp/127.0.0.1:7447')\n"
+                    "-r 'role' ['pub', 'sub', ...]\n"
+                    "-t message type\n"
+                    "-s payload size in bytes\n"
+                    "-n number of messages\n"
+                    "-d pipeline/batch depth\n"
+                    "-p publish period in us\n"
+                    "-P number of publishers\n"
+                    "-S number of subscribers\n"
+                    "-T number of threads\n"
+                    "-x number of sessions\n"
+                    "-z run optimized variant\n"
+                );
+                return 1;
+        }
+    }
+    return 0;
+}
+
+uint64_t bench_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t bench_cpu_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void bench_interface_init(bench_args_t* args){
+    fprintf(stderr, "Starting pico-ros interface %s %s\n", args->ifx.mode, args->ifx.locator);
+    while (picoros_interface_init(&args->ifx) == PICOROS_NOT_READY){
+        fprintf(stderr, "Waiting RMW init...\n");
+        z_sleep_s(1);
+    }
+}
+
+void bench_csv_header(const char* header){
+    printf("bench,%s\n", header);
+}
+
+void bench_csv_row(const char* bench, const char* fmt, ...){
+    va_list ap;
+    va_start(ap, fmt);
+    printf("%s,", bench);
+    vprintf(fmt, ap);
+    printf("\n");
+    fflush(stdout);
+    va_end(ap);
+}
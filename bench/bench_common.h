@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * @file    bench_common.h
+ * @brief   Common utilities for picoros benchmarks
+ * @date    2026-Oct-18
+ *
+ * @details Argument parsing, timing and allocation counting shared by the
+ *          benchmark programs. Results are printed as CSV lines so runs can be
+ *          collected and compared across versions.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#ifndef BENCH_COMMON_H_
+#define BENCH_COMMON_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include "picoros.h"
+#include "picoalloc.h"
+
+/**
+ * @brief Benchmark command line arguments
+ */
+typedef struct {
+    picoros_interface_t ifx;        /**< Network interface (-m mode, -a locator) */
+    const char*         role;       /**< Benchmark role (-r), e.g. "pub" or "sub" */
+    const char*         type;       /**< Message type (-t), benchmark specific */
+    size_t              size;       /**< Payload size in bytes (-s) */
+    uint32_t            count;      /**< Number of messages or iterations (-n) */
+    uint32_t            depth;      /**< Pipeline/batch depth (-d) */
+    uint32_t            period_us;  /**< Publish period in microseconds (-p), 0 = as fast as possible */
+    uint32_t            publishers; /**< Number of publishers (-P) */
+    uint32_t            subscribers;/**< Number of subscribers (-S) */
+    uint32_t            threads;    /**< Number of worker threads (-T) */
+    uint32_t            sessions;   /**< Number of sessions (-x) */
+    bool                variant;    /**< Run optimized variant of benchmark (-z) */
+} bench_args_t;
+
+/**
+ * @brief Parse common benchmark arguments, keeps defaults for missing ones
+ * @return 0 on success
+ */
+int bench_parse_args(int argc, char** argv, bench_args_t* args);
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * @brief Process CPU time (user + system) in nanoseconds
+ */
+uint64_t bench_cpu_ns(void);
+
+/**
+ * @brief Open interface, retrying until router is available
+ */
+void bench_interface_init(bench_args_t* args);
+
+/**
+ * @brief Print CSV header, first column is benchmark name
+ * @param header Column names of benchmark specific values, comma separated
+ */
+void bench_csv_header(const char* header);
+
+/**
+ * @brief Print CSV row
+ * @param bench Benchmark name
+ * @param fmt printf format of benchmark specific values
+ */
+void bench_csv_row(const char* bench, const char* fmt, ...);
+
+#endif /* BENCH_COMMON_H_ */
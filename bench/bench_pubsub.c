@@ -0,0 +1,481 @@
+/*******************************************************************************
+ * @file    bench_pubsub.c
+ * @brief   Publisher/subscriber latency and throughput benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Ping-pong and flood tests between two local zenoh-pico peers with
+ *          ros_Imu, ros_JointState, ros_PointCloud2 and ros_Image messages.
+ *          Sized types sweep payloads from 64 B to 8 MB unless "-s" is given,
+ *          "-t" limits the run to one type (imu, joint_state, pointcloud2, image).
+ *
+ *          Latency:    bench_pubsub -r pong   and   bench_pubsub -r ping
+ *          Throughput: bench_pubsub -r sub    and   bench_pubsub -r pub
+ *
+ *          By default pong/sub listen as peer on tcp/127.0.0.1:7448 and ping/pub
+ *          connect to it, no router is needed. For UDP run both with
+ *          "-m peer -a udp/224.0.0.224:7448#iface=lo". Payloads above zenoh-pico
+ *          FRAG_MAX_SIZE are dropped by the receiver, configure zenoh-pico with
+ *          a larger FRAG_MAX_SIZE to cover the whole sweep.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+#define MAX_RUNS        64
+#define HEADER_ROOM     1024            // serialized size beyond payload data
+#define RUN_MAX_BYTES   (1ull << 30)    // caps messages per run of large payloads
+#define REPLY_TIMEOUT   1000000000ull   // ping reply timeout in ns
+
+/**
+ * @brief Benchmarked message type
+ */
+typedef struct {
+    const char* name;                                   /**< Name used with -t and in topic names */
+    const char* type;                                   /**< ROS type name */
+    const char* hash;                                   /**< ROS type hash */
+    bool        sized;                                  /**< Payload size follows -s or the sweep */
+    size_t    (*serialize)(uint8_t* buf, size_t buf_size, size_t size, ros_Header* header);
+    bool      (*deserialize)(picoros_rx_view_t* view, ros_Header* header);
+} bench_type_t;
+
+/**
+ * @brief One type and payload size combination of a test
+ */
+typedef struct {
+    const bench_type_t* type;
+    size_t              size;                           /**< Requested payload size, 0 for fixed size types */
+    uint32_t            count;                          /**< Number of messages */
+} bench_run_t;
+
+/**
+ * @brief Flood subscriber counters of a run
+ */
+typedef struct {
+    const bench_type_t* type;
+    uint32_t            received;
+    uint64_t            bytes;
+    uint64_t            first_ns;
+    uint64_t            last_ns;
+} flood_result_t;
+
+static bench_args_t args = {
+    .ifx = {
+        .locator = "tcp/127.0.0.1:7448",
+    },
+    .role = "ping",
+    .count = 1000,
+};
+
+static picoros_node_t node = {
+    .name = "bench_pubsub",
+};
+
+static const size_t sweep_sizes[] = {
+    64, 256, 1024, 4096, 16384, 65536, 262144, 1 << 20, 4 << 20, 8 << 20,
+};
+
+// Deserialize view directly or through fragmented reader
+#define VIEW_DESERIALIZE(view, msg, reader)                                         \
+    (((view)->data != NULL) ? ps_deserialize((view)->data, (msg), (view)->len)      \
+                            : (ps_reader_init((reader), picoros_rx_view_next, (view)) && \
+                               ps_deserialize_reader((reader), (msg))))
+
+/* ----- message contents ----------------------------------------------------*/
+static size_t     max_size;
+static uint8_t*   tx_bytes;
+static uint8_t*   rx_bytes;
+static double*    tx_doubles;
+static double*    rx_doubles;
+static rstring*   tx_names;
+static rstring*   rx_names;
+static uint32_t   max_joints;
+static ros_PointField cloud_fields[] = {
+    {.name = "x", .offset = 0, .datatype = 7, .count = 1},
+    {.name = "y", .offset = 4, .datatype = 7, .count = 1},
+    {.name = "z", .offset = 8, .datatype = 7, .count = 1},
+    {.name = "intensity", .offset = 12, .datatype = 7, .count = 1},
+};
+static ros_PointField rx_fields[8];
+
+static size_t imu_serialize(uint8_t* buf, size_t buf_size, size_t size, ros_Header* header){
+    ros_Imu msg = {
+        .header = *header,
+        .orientation.w = 1.0,
+        .linear_acceleration.z = 9.81,
+    };
+    return ps_serialize(buf, &msg, buf_size);
+}
+
+static bool imu_deserialize(picoros_rx_view_t* view, ros_Header* header){
+    ros_Imu msg = {0};
+    ps_reader_t reader;
+    bool ok = VIEW_DESERIALIZE(view, &msg, &reader);
+    *header = msg.header;
+    return ok;
+}
+
+static size_t joint_state_serialize(uint8_t* buf, size_t buf_size, size_t size, ros_Header* header){
+    // name "joint" and three doubles take 36 bytes per joint
+    uint32_t n = size / 36;
+    n = (n == 0) ? 1 : (n > max_joints ? max_joints : n);
+    ros_JointState msg = {
+        .header = *header,
+        .name = {.data = tx_names, .n_elements = n},
+        .position = {.data = tx_doubles, .n_elements = n},
+        .velocity = {.data = tx_doubles, .n_elements = n},
+        .effort = {.data = tx_doubles, .n_elements = n},
+    };
+    return ps_serialize(buf, &msg, buf_size);
+}
+
+static bool joint_state_deserialize(picoros_rx_view_t* view, ros_Header* header){
+    // position, velocity and effort are only read, they share storage
+    ros_JointState msg = {
+        .name = {.data = rx_names, .n_elements = max_joints},
+        .position = {.data = rx_doubles, .n_elements = max_joints},
+        .velocity = {.data = rx_doubles, .n_elements = max_joints},
+        .effort = {.data = rx_doubles, .n_elements = max_joints},
+    };
+    ps_reader_t reader;
+    bool ok = VIEW_DESERIALIZE(view, &msg, &reader);
+    *header = msg.header;
+    return ok;
+}
+
+static size_t pointcloud2_serialize(uint8_t* buf, size_t buf_size, size_t size, ros_Header* header){
+    uint32_t width = (size < 16) ? 1 : size / 16;
+    ros_PointCloud2 msg = {
+        .header = *header,
+        .height = 1,
+        .width = width,
+        .fields = {.data = cloud_fields, .n_elements = sizeof(cloud_fields) / sizeof(cloud_fields[0])},
+        .point_step = 16,
+        .row_step = width * 16,
+        .data = {.data = tx_bytes, .n_elements = width * 16},
+        .is_dense = true,
+    };
+    return ps_serialize(buf, &msg, buf_size);
+}
+
+static bool pointcloud2_deserialize(picoros_rx_view_t* view, ros_Header* header){
+    ros_PointCloud2 msg = {
+        .fields = {.data = rx_fields, .n_elements = sizeof(rx_fields) / sizeof(rx_fields[0])},
+        .data = {.data = rx_bytes, .n_elements = max_size},
+    };
+    ps_reader_t reader;
+    bool ok = VIEW_DESERIALIZE(view, &msg, &reader);
+    *header = msg.header;
+    return ok;
+}
+
+static size_t image_serialize(uint8_t* buf, size_t buf_size, size_t size, ros_Header* header){
+    ros_Image msg = {
+        .header = *header,
+        .height = 1,
+        .width = size,
+        .encoding = "mono8",
+        .step = size,
+        .data = {.data = tx_bytes, .n_elements = size},
+    };
+    return ps_serialize(buf, &msg, buf_size);
+}
+
+static bool image_deserialize(picoros_rx_view_t* view, ros_Header* header){
+    ros_Image msg = {
+        .data = {.data = rx_bytes, .n_elements = max_size},
+    };
+    ps_reader_t reader;
+    bool ok = VIEW_DESERIALIZE(view, &msg, &reader);
+    *header = msg.header;
+    return ok;
+}
+
+#define N_TYPES 4
+static const bench_type_t types[N_TYPES] = {
+    {"imu", ROSTYPE_NAME(ros_Imu), ROSTYPE_HASH(ros_Imu), false, imu_serialize, imu_deserialize},
+    {"joint_state", ROSTYPE_NAME(ros_JointState), ROSTYPE_HASH(ros_JointState), true,
+     joint_state_serialize, joint_state_deserialize},
+    {"pointcloud2", ROSTYPE_NAME(ros_PointCloud2), ROSTYPE_HASH(ros_PointCloud2), true,
+     pointcloud2_serialize, pointcloud2_deserialize},
+    {"image", ROSTYPE_NAME(ros_Image), ROSTYPE_HASH(ros_Image), true, image_serialize, image_deserialize},
+};
+
+static bench_run_t runs[MAX_RUNS];
+static uint32_t n_runs;
+
+// Build run list from arguments, both sides of a test get the same list
+static void runs_init(void){
+    size_t n_sizes = args.size ? 1 : sizeof(sweep_sizes) / sizeof(sweep_sizes[0]);
+    for (uint32_t t = 0; t < N_TYPES; t++){
+        if (args.type != NULL && strcmp(args.type, types[t].name) != 0){
+            continue;
+        }
+        for (size_t s = 0; s < (types[t].sized ? n_sizes : 1) && n_runs < MAX_RUNS; s++){
+            size_t size = !types[t].sized ? 0 : (args.size ? args.size : sweep_sizes[s]);
+            uint64_t count = args.count;
+            if (size != 0 && count * size > RUN_MAX_BYTES){
+                count = RUN_MAX_BYTES / size < 16 ? 16 : RUN_MAX_BYTES / size;
+            }
+            runs[n_runs++] = (bench_run_t){.type = &types[t], .size = size, .count = count};
+            if (size > max_size){
+                max_size = size;
+            }
+        }
+    }
+}
+
+static void buffers_init(void){
+    max_size = (max_size < 1024) ? 1024 : max_size;
+    max_joints = max_size / 8;
+    tx_bytes = z_malloc(max_size);
+    rx_bytes = z_malloc(max_size);
+    tx_doubles = z_malloc(max_joints * sizeof(double));
+    rx_doubles = z_malloc(max_joints * sizeof(double));
+    tx_names = z_malloc(max_joints * sizeof(rstring));
+    rx_names = z_malloc(max_joints * sizeof(rstring));
+    memset(tx_bytes, 0x5a, max_size);
+    for (uint32_t i = 0; i < max_joints; i++){
+        tx_doubles[i] = i * 0.001;
+        tx_names[i] = "joint";
+    }
+}
+
+static void topic_init(rmw_topic_t* topic, const char* prefix, const bench_type_t* type){
+    char* name = z_malloc(64);
+    snprintf(name, 64, "bench/%s/%s", prefix, type->name);
+    topic->name = name;
+    topic->type = type->type;
+    topic->rihs_hash = type->hash;
+}
+
+// Copy payload of view to buf, returns payload size or 0 if it does not fit
+static size_t view_gather(picoros_rx_view_t* view, uint8_t* buf, size_t size){
+    if (view->len > size){
+        return 0;
+    }
+    if (view->data != NULL){
+        memcpy(buf, view->data, view->len);
+        return view->len;
+    }
+    const uint8_t* data;
+    size_t len;
+    size_t total = 0;
+    while (picoros_rx_view_next(view, &data, &len)){
+        memcpy(buf + total, data, len);
+        total += len;
+    }
+    return total;
+}
+
+static int compare_u64(const void* a, const void* b){
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static picoros_publisher_t pubs[N_TYPES];
+static picoros_subscriber_t subs[N_TYPES];
+static uint8_t* tx_buf;
+static size_t tx_buf_size;
+
+static void declare_all(const char* pub_prefix, const char* sub_prefix, picoros_sub_view_cb_t callback){
+    for (uint32_t t = 0; t < N_TYPES; t++){
+        if (pub_prefix != NULL){
+            topic_init(&pubs[t].topic, pub_prefix, &types[t]);
+            picoros_publisher_declare(&node, &pubs[t]);
+        }
+        if (sub_prefix != NULL){
+            topic_init(&subs[t].topic, sub_prefix, &types[t]);
+            subs[t].view_callback = callback;
+            subs[t].user_data = (void*)&types[t];
+            picoros_subscriber_declare(&node, &subs[t]);
+        }
+    }
+}
+
+/* ----- ping-pong -----------------------------------------------------------*/
+static uint32_t reply_seq;
+
+static void pong_callback(picoros_subscriber_t* sub, picoros_rx_view_t* view){
+    size_t len = view_gather(view, tx_buf, tx_buf_size);
+    if (len != 0){
+        picoros_publish(&pubs[sub - subs], tx_buf, len);
+    }
+}
+
+static void ping_callback(picoros_subscriber_t* sub, picoros_rx_view_t* view){
+    ros_Header header = {0};
+    const bench_type_t* type = sub->user_data;
+    if (type->deserialize(view, &header)){
+        __atomic_store_n(&reply_seq, header.stamp.nanosec, __ATOMIC_RELEASE);
+    }
+}
+
+static void ping_run(bench_run_t* run, uint32_t run_idx, uint32_t* seq){
+    uint64_t* rtt_ns = z_malloc(run->count * sizeof(uint64_t));
+    picoros_publisher_t* pub = &pubs[run->type - types];
+    uint32_t warmup = run->count / 10 + 1;
+    uint32_t ok = 0;
+    uint32_t lost = 0;
+    size_t len = 0;
+    uint64_t start = 0;
+
+    for (uint32_t i = 0; i < warmup + run->count; i++){
+        if (i == warmup){
+            start = bench_now_ns();
+        }
+        ros_Header header = {.frame_id = "bench", .stamp = {.sec = run_idx, .nanosec = ++(*seq)}};
+        uint64_t t0 = bench_now_ns();
+        len = run->type->serialize(tx_buf, tx_buf_size, run->size, &header);
+        picoros_publish(pub, tx_buf, len);
+        uint64_t t1 = t0;
+        while (__atomic_load_n(&reply_seq, __ATOMIC_ACQUIRE) != *seq && t1 - t0 < REPLY_TIMEOUT){
+            t1 = bench_now_ns();
+        }
+        if (i < warmup){
+            continue;
+        }
+        if (t1 - t0 < REPLY_TIMEOUT){
+            rtt_ns[ok++] = t1 - t0;
+        }
+        else{
+            lost++;
+        }
+        if (args.period_us){
+            z_sleep_us(args.period_us);
+        }
+    }
+    double elapsed_s = (double)(bench_now_ns() - start) / 1e9;
+    if (ok == 0){
+        bench_csv_row("pingpong", "%s,%zu,0,%" PRIu32 ",0,0,0,0,0", run->type->name, len, lost);
+    }
+    else{
+        qsort(rtt_ns, ok, sizeof(uint64_t), compare_u64);
+        bench_csv_row("pingpong", "%s,%zu,%" PRIu32 ",%" PRIu32 ",%.1f,%.2f,%.1f,%.1f,%.1f",
+                      run->type->name, len, ok, lost,
+                      ok / elapsed_s,
+                      (double)ok * len / elapsed_s / 1e6,
+                      rtt_ns[ok / 2] / 1000.0,
+                      rtt_ns[(uint64_t)ok * 99 / 100] / 1000.0,
+                      rtt_ns[(uint64_t)ok * 999 / 1000] / 1000.0);
+    }
+    z_free(rtt_ns);
+}
+
+/* ----- flood ---------------------------------------------------------------*/
+static flood_result_t results[MAX_RUNS];
+static volatile uint64_t last_rx_ns;
+
+static void flood_callback(picoros_subscriber_t* sub, picoros_rx_view_t* view){
+    uint64_t now = bench_now_ns();
+    ros_Header header = {0};
+    const bench_type_t* type = sub->user_data;
+    if (!type->deserialize(view, &header) || (uint32_t)header.stamp.sec >= n_runs){
+        return;
+    }
+    flood_result_t* res = &results[header.stamp.sec];
+    if (res->received == 0){
+        res->type = type;
+        res->first_ns = now;
+    }
+    res->received++;
+    res->bytes += view->len;
+    res->last_ns = now;
+    last_rx_ns = now;
+}
+
+static void flood_publish(void){
+    for (uint32_t r = 0; r < n_runs; r++){
+        bench_run_t* run = &runs[r];
+        fprintf(stderr, "Flooding %s %zu B x %" PRIu32 "\n", run->type->name, run->size, run->count);
+        for (uint32_t i = 0; i < run->count; i++){
+            ros_Header header = {.frame_id = "bench", .stamp = {.sec = r, .nanosec = i}};
+            size_t len = run->type->serialize(tx_buf, tx_buf_size, run->size, &header);
+            picoros_publish(&pubs[run->type - types], tx_buf, len);
+            if (args.period_us){
+                z_sleep_us(args.period_us);
+            }
+        }
+        // let subscriber drain before next run
+        z_sleep_ms(500);
+    }
+}
+
+static void flood_report(void){
+    bench_csv_header("type,payload_bytes,messages,lost,msgs_per_s,mb_per_s");
+    for (uint32_t r = 0; r < n_runs; r++){
+        flood_result_t* res = &results[r];
+        uint32_t lost = runs[r].count - (res->received < runs[r].count ? res->received : runs[r].count);
+        if (res->received < 2){
+            bench_csv_row("flood", "%s,0,%" PRIu32 ",%" PRIu32 ",0,0", runs[r].type->name, res->received, lost);
+            continue;
+        }
+        // first sample starts the clock, rates are over the remaining ones
+        double elapsed_s = (double)(res->last_ns - res->first_ns) / 1e9;
+        double avg_len = (double)res->bytes / res->received;
+        bench_csv_row("flood", "%s,%.0f,%" PRIu32 ",%" PRIu32 ",%.1f,%.2f",
+                      runs[r].type->name, avg_len, res->received, lost,
+                      (res->received - 1) / elapsed_s,
+                      (res->received - 1) * avg_len / elapsed_s / 1e6);
+    }
+}
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    bool responder = strcmp(args.role, "pong") == 0 || strcmp(args.role, "sub") == 0;
+    if (args.ifx.mode == NULL){
+        args.ifx.mode = responder ? "peer" : "client";
+    }
+    runs_init();
+    if (n_runs == 0){
+        fprintf(stderr, "Unknown type %s\n", args.type);
+        return 1;
+    }
+    if (strcmp(args.role, "pong") == 0 && args.size == 0){
+        max_size = sweep_sizes[sizeof(sweep_sizes) / sizeof(sweep_sizes[0]) - 1];
+    }
+    buffers_init();
+    tx_buf_size = max_size + HEADER_ROOM;
+    tx_buf = z_malloc(tx_buf_size);
+
+    bench_interface_init(&args);
+    picoros_node_init(&node);
+
+    if (strcmp(args.role, "pong") == 0){
+        declare_all("pong", "ping", pong_callback);
+        while (true){
+            z_sleep_s(1);
+        }
+    }
+    else if (strcmp(args.role, "ping") == 0){
+        declare_all("ping", "pong", ping_callback);
+        // wait for pong to match
+        z_sleep_s(1);
+        bench_csv_header("type,payload_bytes,messages,lost,msgs_per_s,mb_per_s,rtt_p50_us,rtt_p99_us,rtt_p999_us");
+        uint32_t seq = 0;
+        for (uint32_t r = 0; r < n_runs; r++){
+            ping_run(&runs[r], r, &seq);
+        }
+    }
+    else if (strcmp(args.role, "pub") == 0){
+        declare_all("flood", NULL, NULL);
+        z_sleep_s(1);
+        flood_publish();
+    }
+    else{
+        declare_all(NULL, "flood", flood_callback);
+        while (last_rx_ns == 0 || bench_now_ns() - last_rx_ns < 2000000000ull){
+            z_sleep_ms(10);
+        }
+        flood_report();
+    }
+    return 0;
+}
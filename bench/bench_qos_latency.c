@@ -0,0 +1,182 @@
+/*******************************************************************************
+ * @file    bench_qos_latency.c
+ * @brief   Command latency under saturating bulk stream benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Publisher role sends ros_Image bulk data as fast as possible from a
+ *          background task and ros_TwistStamped commands at a fixed period.
+ *          Subscriber role measures one-way command latency from the send time
+ *          in the command stamp, both roles must run on the same host.
+ *          With "-z" commands use real time priority and bulk data best effort
+ *          background priority, otherwise both use default QoS.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+static bench_args_t args = {
+    .ifx = {
+        .mode = "client",
+        .locator = "tcp/127.0.0.1:7447",
+    },
+    .role = "sub",
+    .size = 256 * 1024,
+    .count = 5000,
+    .period_us = 1000,  // 1 kHz command rate
+};
+
+static picoros_node_t node = {
+    .name = "bench_qos_latency",
+};
+
+static picoros_publisher_t pub_cmd = {
+    .topic = {
+        .name = "bench/cmd_vel",
+        .type = ROSTYPE_NAME(ros_TwistStamped),
+        .rihs_hash = ROSTYPE_HASH(ros_TwistStamped),
+    },
+};
+static picoros_publisher_t pub_bulk = {
+    .topic = {
+        .name = "bench/image",
+        .type = ROSTYPE_NAME(ros_Image),
+        .rihs_hash = ROSTYPE_HASH(ros_Image),
+    },
+};
+
+static const picoros_qos_t cmd_qos = {
+    .reliability = PICOROS_RELIABILITY_RELIABLE,
+    .history = PICOROS_HISTORY_KEEP_LAST,
+    .depth = 1,
+    .priority = Z_PRIORITY_REAL_TIME,
+    .deadline_ms = 10,
+};
+static const picoros_qos_t bulk_qos = {
+    .reliability = PICOROS_RELIABILITY_BEST_EFFORT,
+    .history = PICOROS_HISTORY_KEEP_LAST,
+    .depth = 1,
+    .priority = Z_PRIORITY_BACKGROUND,
+};
+
+static volatile bool running = true;
+static uint64_t* latency_ns;
+static volatile uint32_t commands;
+static volatile uint32_t bulk_samples;
+
+static void* bulk_task(void* arg){
+    size_t buf_size = args.size + 256;
+    uint8_t* buf = z_malloc(buf_size);
+    uint8_t* data = z_malloc(args.size);
+    memset(data, 0x5a, args.size);
+    ros_Image img = {
+        .header.frame_id = "bench",
+        .height = 1,
+        .width = args.size,
+        .encoding = "mono8",
+        .step = args.size,
+        .data = {.data = data, .n_elements = args.size},
+    };
+    size_t len = ps_serialize(buf, &img, buf_size);
+    while (running){
+        picoros_publish(&pub_bulk, buf, len);
+    }
+    return NULL;
+}
+
+static void publish_commands(void){
+    uint8_t buf[128];
+    z_owned_task_t task;
+    z_task_init(&task, NULL, bulk_task, NULL);
+    // let bulk stream saturate transport first
+    z_sleep_ms(500);
+    for (uint32_t i = 0; i < args.count + 100; i++){
+        uint64_t now = bench_now_ns();
+        ros_TwistStamped cmd = {
+            .header = {
+                .frame_id = "base",
+                .stamp.sec = now / 1000000000u,
+                .stamp.nanosec = now % 1000000000u,
+            },
+            .twist.linear.x = 0.5,
+        };
+        size_t len = ps_serialize(buf, &cmd, sizeof(buf));
+        picoros_publish(&pub_cmd, buf, len);
+        z_sleep_us(args.period_us);
+    }
+    running = false;
+    z_task_join(z_task_move(&task));
+}
+
+static void cmd_callback(uint8_t* rx_data, size_t data_len){
+    uint64_t now = bench_now_ns();
+    ros_TwistStamped cmd = {};
+    if (!ps_deserialize(rx_data, &cmd, data_len) || commands >= args.count){
+        return;
+    }
+    latency_ns[commands++] = now - ((uint64_t)cmd.header.stamp.sec * 1000000000u + cmd.header.stamp.nanosec);
+}
+
+static void bulk_callback(picoros_subscriber_t* sub, picoros_rx_view_t* view){
+    bulk_samples++;
+}
+
+static int compare_u64(const void* a, const void* b){
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    if (args.variant){
+        pub_cmd.qos = cmd_qos;
+        pub_bulk.qos = bulk_qos;
+    }
+    bench_interface_init(&args);
+    picoros_node_init(&node);
+
+    if (strcmp(args.role, "pub") == 0){
+        picoros_publisher_declare(&node, &pub_cmd);
+        picoros_publisher_declare(&node, &pub_bulk);
+        publish_commands();
+        return 0;
+    }
+
+    static picoros_subscriber_t sub_cmd = {.user_callback = cmd_callback};
+    static picoros_subscriber_t sub_bulk = {.view_callback = bulk_callback};
+    sub_cmd.topic = pub_cmd.topic;
+    sub_cmd.qos = pub_cmd.qos;
+    sub_bulk.topic = pub_bulk.topic;
+    sub_bulk.qos = pub_bulk.qos;
+    latency_ns = z_malloc(args.count * sizeof(uint64_t));
+    picoros_subscriber_declare(&node, &sub_cmd);
+    picoros_subscriber_declare(&node, &sub_bulk);
+
+    bench_csv_header("mode,bulk_bytes,commands,bulk_samples,bulk_mb_per_s,p50_us,p99_us,max_us");
+    while (commands == 0){
+        z_sleep_ms(1);
+    }
+    uint32_t start_bulk = bulk_samples;
+    uint64_t start = bench_now_ns();
+    while (commands < args.count){
+        z_sleep_ms(10);
+    }
+    double elapsed_s = (double)(bench_now_ns() - start) / 1e9;
+    uint32_t bulk = bulk_samples - start_bulk;
+    qsort(latency_ns, args.count, sizeof(uint64_t), compare_u64);
+    bench_csv_row("qos_latency", "%s,%zu,%" PRIu32 ",%" PRIu32 ",%.1f,%.1f,%.1f,%.1f",
+                  args.variant ? "qos" : "default", args.size, args.count, bulk,
+                  (double)bulk * args.size / elapsed_s / 1e6,
+                  latency_ns[args.count / 2] / 1000.0,
+                  latency_ns[(uint64_t)args.count * 99 / 100] / 1000.0,
+                  latency_ns[args.count - 1] / 1000.0);
+    return 0;
+}
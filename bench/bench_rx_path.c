@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * @file    bench_rx_path.c
+ * @brief   Subscriber receive path benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Compares copies and heap allocations per received sample between the
+ *          copying subscriber callback and the zero-copy view callback.
+ *          Run one instance with "-r pub" and one with "-r sub", add "-z" to the
+ *          subscriber to use the zero-copy path.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+static bench_args_t args = {
+    .ifx = {
+        .mode = "client",
+        .locator = "tcp/127.0.0.1:7447",
+    },
+    .role = "sub",
+    .size = 64 * 1024,
+    .count = 1000,
+};
+
+static picoros_node_t node = {
+    .name = "bench_rx_path",
+};
+
+static rmw_topic_t topic = {
+    .name = "bench/image",
+    .type = ROSTYPE_NAME(ros_Image),
+    .rihs_hash = ROSTYPE_HASH(ros_Image),
+};
+
+static uint8_t*  image_data;
+static uint32_t  samples;
+static uint64_t  copied_bytes;
+static uint64_t  start_cpu;
+static picoalloc_stats_t start_alloc;
+
+static void sample_done(size_t len, bool ok){
+    if (!ok){
+        fprintf(stderr, "Deserialization failed\n");
+    }
+    if (samples == 0){
+        start_cpu = bench_cpu_ns();
+        picoalloc_read(&start_alloc);
+    }
+    samples++;
+    if (samples == args.count + 1){
+        picoalloc_stats_t end_alloc;
+        picoalloc_read(&end_alloc);
+        uint64_t n = args.count;
+        bench_csv_row("rx_path", "%s,%zu,%" PRIu64 ",%.2f,%.1f,%.1f,%.1f",
+                      args.variant ? "view" : "copy", len, n,
+                      (double)(end_alloc.allocs - start_alloc.allocs) / n,
+                      (double)(end_alloc.bytes - start_alloc.bytes) / n,
+                      (double)copied_bytes / n,
+                      (double)(bench_cpu_ns() - start_cpu) / n);
+    }
+}
+
+static void copy_callback(uint8_t* rx_data, size_t data_len){
+    ros_Image img = {.data = {.data = image_data, .n_elements = args.size}};
+    bool ok = ps_deserialize(rx_data, &img, data_len);
+    if (samples > 0){
+        copied_bytes += data_len; // payload copied by picoros before callback
+    }
+    sample_done(data_len, ok);
+}
+
+static void view_callback(picoros_subscriber_t* sub, picoros_rx_view_t* view){
+    ros_Image img = {.data = {.data = image_data, .n_elements = args.size}};
+    bool ok;
+    if (view->data != NULL){
+        ok = ps_deserialize(view->data, &img, view->len);
+    }
+    else{
+        ps_reader_t reader;
+        ok = ps_reader_init(&reader, picoros_rx_view_next, view) && ps_deserialize_reader(&reader, &img);
+        if (samples > 0){
+            copied_bytes += reader.stitched;
+        }
+    }
+    sample_done(view->len, ok);
+}
+
+static picoros_subscriber_t sub;
+static picoros_publisher_t pub;
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    image_data = z_malloc(args.size);
+    memset(image_data, 0x5a, args.size);
+
+    bench_interface_init(&args);
+    picoros_node_init(&node);
+
+    if (strcmp(args.role, "pub") == 0){
+        size_t buf_size = args.size + 256;
+        uint8_t* buf = z_malloc(buf_size);
+        pub.topic = topic;
+        picoros_publisher_declare(&node, &pub);
+        ros_Image img = {
+            .header.frame_id = "bench",
+            .height = 1,
+            .width = args.size,
+            .encoding = "mono8",
+            .step = args.size,
+            .data = {.data = image_data, .n_elements = args.size},
+        };
+        uint64_t steady_allocs = 0;
+        for (uint32_t i = 0; args.count == 0 || i < args.count * 2; i++){
+            img.header.stamp.sec = i;
+            // first publish may set up transport state, later ones should not allocate
+            picoalloc_guard_begin(false);
+            size_t len = ps_serialize(buf, &img, buf_size);
+            picoros_publish(&pub, buf, len);
+            uint32_t allocs = picoalloc_guard_end();
+            if (i > 0){
+                steady_allocs += allocs;
+            }
+            z_sleep_us(args.period_us ? args.period_us : 1000);
+        }
+        fprintf(stderr, "Publish path allocations after first message: %" PRIu64 "\n", steady_allocs);
+        return 0;
+    }
+
+    bench_csv_header("mode,payload_bytes,samples,allocs_per_sample,alloc_bytes_per_sample,copied_bytes_per_sample,cpu_ns_per_sample");
+    sub.topic = topic;
+    if (args.variant){
+        sub.view_callback = view_callback;
+    }
+    else{
+        sub.user_callback = copy_callback;
+    }
+    picoros_subscriber_declare(&node, &sub);
+    while (samples <= args.count){
+        z_sleep_ms(10);
+    }
+    return 0;
+}
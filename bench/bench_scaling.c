@@ -0,0 +1,273 @@
+/*******************************************************************************
+ * @file    bench_scaling.c
+ * @brief   Publisher/subscriber/thread scaling benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Publishes from "-P" publishers, each on its own topic, driven by "-T"
+ *          threads to "-S" subscribers spread round robin over the topics.
+ *          Each side opens "-x" sessions and declares entity i on session
+ *          i % sessions, "-z" pins session read tasks to cores.
+ *          Role "all" runs both sides in one process on separate sessions,
+ *          "pub" and "sub" split them over processes, several "pub" processes
+ *          can feed one "sub". All roles connect to a router.
+ *
+ *          Rows report the CPU cores available to the process, so runs under
+ *          taskset with growing core counts can be compared. Latency comes from
+ *          the rmw attachment timestamp, per topic and merged over all topics.
+ *          In role "all" CPU per message is reported on the subscriber row and
+ *          covers the whole process.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+#define TOPIC_NAME_SIZE 32
+#define IDLE_END_NS     2000000000ull   // subscriber run ends after this long without samples
+
+/**
+ * @brief Sessions and their nodes of one side of the benchmark
+ */
+typedef struct {
+    picoros_shard_t  shard;
+    picoros_node_t*  nodes;
+} bench_side_t;
+
+static bench_args_t args = {
+    .ifx = {
+        .mode = "client",
+        .locator = "tcp/127.0.0.1:7447",
+    },
+    .role = "all",
+    .size = 256,
+    .count = 10000,
+    .publishers = 4,
+    .subscribers = 4,
+    .threads = 1,
+    .sessions = 1,
+};
+
+static char (*topic_names)[TOPIC_NAME_SIZE];
+
+static picoros_publisher_t* pubs;
+static uint8_t*  tx_buf;
+static size_t    tx_len;
+static bool      start_flag;
+static uint64_t  sent;
+
+static picoros_subscriber_t*   subs;
+static picoros_latency_hist_t* hists;
+static uint64_t* topic_rx;
+static uint64_t  rx_bytes;
+static uint64_t  first_rx_ns;
+static uint64_t  last_rx_ns;
+
+static uint32_t bench_cores(void){
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0){
+        return CPU_COUNT(&set);
+    }
+    return sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void side_open(bench_side_t* side, const char* name){
+    side->shard.sessions = calloc(args.sessions, sizeof(picoros_session_t));
+    side->shard.n_shards = args.sessions;
+    side->shard.pin_cores = args.variant;
+    fprintf(stderr, "Opening %" PRIu32 " %s sessions %s %s\n", args.sessions, name, args.ifx.mode, args.ifx.locator);
+    while (picoros_shard_init(&side->shard, &args.ifx) == PICOROS_NOT_READY){
+        fprintf(stderr, "Waiting RMW init...\n");
+        z_sleep_s(1);
+    }
+    side->nodes = calloc(args.sessions, sizeof(picoros_node_t));
+    for (uint32_t s = 0; s < args.sessions; s++){
+        char* node_name = malloc(TOPIC_NAME_SIZE);
+        snprintf(node_name, TOPIC_NAME_SIZE, "bench_scaling_%s_%" PRIu32, name, s);
+        side->nodes[s].name = node_name;
+        side->nodes[s].session = &side->shard.sessions[s];
+        picoros_node_init(&side->nodes[s]);
+    }
+}
+
+static void topic_init(rmw_topic_t* topic, uint32_t idx){
+    topic->name = topic_names[idx];
+    topic->type = ROSTYPE_NAME(ros_Image);
+    topic->rihs_hash = ROSTYPE_HASH(ros_Image);
+}
+
+static void csv_row(const char* role, const char* topic, uint64_t messages, double elapsed_s,
+                    uint64_t bytes, uint64_t cpu_ns, const picoros_latency_hist_t* hist){
+    if (elapsed_s <= 0){
+        elapsed_s = 1e-9;
+    }
+    bench_csv_row("scaling", "%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%zu,%s,%" PRIu64
+                  ",%.1f,%.2f,%.0f,%" PRIu32 ",%" PRIu32 ",%" PRIu32,
+                  role, bench_cores(), args.publishers, args.subscribers, args.threads, args.sessions,
+                  tx_len, topic, messages,
+                  messages / elapsed_s,
+                  bytes / elapsed_s / 1e6,
+                  messages ? (double)cpu_ns / messages : 0.0,
+                  hist ? picoros_latency_percentile(hist, 50) : 0,
+                  hist ? picoros_latency_percentile(hist, 99) : 0,
+                  hist ? picoros_latency_percentile(hist, 99.9) : 0);
+}
+
+/* ----- publishers ----------------------------------------------------------*/
+
+static void* pub_task(void* arg){
+    uint32_t t = (uint32_t)(uintptr_t)arg;
+    while (!__atomic_load_n(&start_flag, __ATOMIC_ACQUIRE)){
+        z_sleep_ms(1);
+    }
+    for (uint32_t i = 0; i < args.count; i++){
+        for (uint32_t p = t; p < args.publishers; p += args.threads){
+            if (picoros_publish(&pubs[p], tx_buf, tx_len) == PICOROS_OK){
+                __atomic_fetch_add(&sent, 1, __ATOMIC_RELAXED);
+            }
+        }
+        if (args.period_us){
+            z_sleep_us(args.period_us);
+        }
+    }
+    return NULL;
+}
+
+static void pub_declare(bench_side_t* side){
+    pubs = calloc(args.publishers, sizeof(picoros_publisher_t));
+    for (uint32_t p = 0; p < args.publishers; p++){
+        topic_init(&pubs[p].topic, p);
+        picoros_publisher_declare(&side->nodes[p % args.sessions], &pubs[p]);
+    }
+}
+
+static void pub_run(bool report){
+    z_owned_task_t* tasks = calloc(args.threads, sizeof(z_owned_task_t));
+    for (uint32_t t = 0; t < args.threads; t++){
+        z_task_init(&tasks[t], NULL, pub_task, (void*)(uintptr_t)t);
+    }
+    uint64_t start_cpu = bench_cpu_ns();
+    uint64_t start = bench_now_ns();
+    __atomic_store_n(&start_flag, true, __ATOMIC_RELEASE);
+    for (uint32_t t = 0; t < args.threads; t++){
+        z_task_join(z_task_move(&tasks[t]));
+    }
+    double elapsed_s = (double)(bench_now_ns() - start) / 1e9;
+    csv_row("pub", "all", sent, elapsed_s, sent * tx_len, report ? bench_cpu_ns() - start_cpu : 0, NULL);
+    free(tasks);
+}
+
+/* ----- subscribers ---------------------------------------------------------*/
+
+static void sub_callback(picoros_subscriber_t* sub, picoros_rx_view_t* view){
+    uint64_t now = bench_now_ns();
+    uint64_t zero = 0;
+    __atomic_compare_exchange_n(&first_rx_ns, &zero, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    __atomic_store_n(&last_rx_ns, now, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&topic_rx[(uintptr_t)sub->user_data], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&rx_bytes, view->len, __ATOMIC_RELAXED);
+}
+
+static void sub_declare(bench_side_t* side){
+    subs = calloc(args.subscribers, sizeof(picoros_subscriber_t));
+    hists = calloc(args.publishers, sizeof(picoros_latency_hist_t));
+    topic_rx = calloc(args.publishers, sizeof(uint64_t));
+    for (uint32_t s = 0; s < args.subscribers; s++){
+        uint32_t topic = s % args.publishers;
+        topic_init(&subs[s].topic, topic);
+        subs[s].view_callback = sub_callback;
+        subs[s].user_data = (void*)(uintptr_t)topic;
+        subs[s].latency = &hists[topic];
+        picoros_subscriber_declare(&side->nodes[s % args.sessions], &subs[s]);
+    }
+}
+
+static void sub_wait_and_report(const char* role, uint64_t start_cpu){
+    while (__atomic_load_n(&last_rx_ns, __ATOMIC_RELAXED) == 0 ||
+           bench_now_ns() - __atomic_load_n(&last_rx_ns, __ATOMIC_RELAXED) < IDLE_END_NS){
+        z_sleep_ms(10);
+    }
+    uint64_t cpu_ns = bench_cpu_ns() - start_cpu;
+    double elapsed_s = (double)(last_rx_ns - first_rx_ns) / 1e9;
+
+    static picoros_latency_hist_t all;
+    uint64_t received = 0;
+    for (uint32_t t = 0; t < args.publishers; t++){
+        received += topic_rx[t];
+        for (uint32_t b = 0; b < PICOROS_LATENCY_BUCKETS; b++){
+            all.counts[b] += hists[t].counts[b];
+        }
+        all.total += hists[t].total;
+        all.max_us = (hists[t].max_us > all.max_us) ? hists[t].max_us : all.max_us;
+    }
+    csv_row(role, "all", received, elapsed_s, rx_bytes, cpu_ns, &all);
+    for (uint32_t t = 0; t < args.publishers; t++){
+        if (topic_rx[t] != 0){
+            csv_row(role, topic_names[t], topic_rx[t], elapsed_s, topic_rx[t] * tx_len, 0, &hists[t]);
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    if (args.publishers == 0 || args.threads == 0 || args.sessions == 0 ||
+        (args.subscribers == 0 && strcmp(args.role, "pub") != 0)){
+        fprintf(stderr, "Publishers, subscribers, threads and sessions must be at least 1\n");
+        return 1;
+    }
+    topic_names = calloc(args.publishers, TOPIC_NAME_SIZE);
+    for (uint32_t p = 0; p < args.publishers; p++){
+        snprintf(topic_names[p], TOPIC_NAME_SIZE, "bench/scale/t%" PRIu32, p);
+    }
+
+    // publishers send one pre-serialized image, receive cost is dispatch only
+    size_t buf_size = args.size + 256;
+    tx_buf = malloc(buf_size);
+    uint8_t* data = calloc(1, args.size);
+    ros_Image img = {
+        .header.frame_id = "bench",
+        .height = 1,
+        .width = args.size,
+        .encoding = "mono8",
+        .step = args.size,
+        .data = {.data = data, .n_elements = args.size},
+    };
+    tx_len = ps_serialize(tx_buf, &img, buf_size);
+
+    bench_side_t pub_side = {0};
+    bench_side_t sub_side = {0};
+    bench_csv_header("role,cores,publishers,subscribers,threads,sessions,payload_bytes,topic,messages,"
+                     "msgs_per_s,mb_per_s,cpu_ns_per_msg,p50_us,p99_us,p999_us");
+    if (strcmp(args.role, "pub") == 0){
+        side_open(&pub_side, "pub");
+        pub_declare(&pub_side);
+        // wait for subscribers to match
+        z_sleep_s(1);
+        pub_run(true);
+    }
+    else if (strcmp(args.role, "sub") == 0){
+        side_open(&sub_side, "sub");
+        sub_declare(&sub_side);
+        sub_wait_and_report("sub", bench_cpu_ns());
+    }
+    else{
+        side_open(&sub_side, "sub");
+        sub_declare(&sub_side);
+        side_open(&pub_side, "pub");
+        pub_declare(&pub_side);
+        z_sleep_s(1);
+        uint64_t start_cpu = bench_cpu_ns();
+        pub_run(false);
+        sub_wait_and_report("all", start_cpu);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * @file    bench_serdes.c
+ * @brief   Serialization/deserialization cost benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Times ps_serialize() and ps_deserialize() of every message, request
+ *          and reply type generated from MSG_LIST and SRV_LIST, filled with
+ *          pseudo random data, against memcpy of the same number of bytes.
+ *          "-n" sets iterations, "-s" elements of every sequence (default 4)
+ *          and "-t" limits the run to one type, e.g. "-t ros_Imu".
+ *          Rows with ok=0 did not round trip, e.g. when the sequence length
+ *          makes the message larger than the serialization buffer.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "picoserdes.h"
+#include "bench_common.h"
+
+#define SER_BUF_SIZE    (4u << 20)
+#define ARENA_SIZE      (64u << 20)
+
+static bench_args_t args = {
+    .size = 4,
+    .count = 10000,
+};
+
+static uint8_t* ser_buf;
+static uint8_t* check_buf;
+static uint8_t* arena;
+static size_t   arena_used;
+static uint64_t rng_state;
+
+static char strings[8][48];
+
+// Keep compiler from dropping stores to p
+#define CLOBBER(p) __asm__ volatile("" : : "r"(p) : "memory")
+
+/* ----- random fill ---------------------------------------------------------*/
+
+static inline uint64_t rng_next(void){
+    // xorshift64
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void* arena_alloc(size_t size){
+    size = (size + 7) & ~(size_t)7;
+    if (arena_used + size > ARENA_SIZE){
+        return NULL;
+    }
+    void* p = arena + arena_used;
+    arena_used += size;
+    return p;
+}
+
+#define FILL_INT(TYPE) \
+    static inline void fill_##TYPE(TYPE* v){ *v = (TYPE)rng_next(); }
+
+FILL_INT(char)
+FILL_INT(int8_t)
+FILL_INT(uint8_t)
+FILL_INT(int16_t)
+FILL_INT(uint16_t)
+FILL_INT(int32_t)
+FILL_INT(uint32_t)
+FILL_INT(int64_t)
+FILL_INT(uint64_t)
+static inline void fill_bool(bool* v){ *v = rng_next() & 1; }
+static inline void fill_float(float* v){ *v = (float)(rng_next() % 1000000) / 1000.0f; }
+static inline void fill_double(double* v){ *v = (double)(rng_next() % 1000000000) / 1000.0; }
+static inline void fill_rstring(rstring* v){ *v = strings[rng_next() % 8]; }
+
+#define FILL_PROTO(TYPE, ...) \
+    static inline void fill_##TYPE(TYPE* msg);
+#define FILL_BTYPE(TYPE, NAME, HASH, TYPE2, ...) \
+    static inline void fill_##TYPE(TYPE* msg){ fill_##TYPE2((TYPE2*)msg); }
+#define FILL_CTYPE(TYPE, NAME, HASH, ...) \
+    static inline void fill_##TYPE(TYPE* msg){ __VA_ARGS__ }
+#define FILL_FIELD(TYPE, NAME) \
+    fill_##TYPE(&msg->NAME);
+#define FILL_ARRAY(TYPE, NAME, SIZE) \
+    for (uint32_t i = 0; i < (SIZE); i++){ fill_##TYPE(&msg->NAME[i]); }
+#define FILL_SEQUENCE(TYPE, NAME)                                           \
+    msg->NAME.data = arena_alloc(args.size * sizeof(TYPE));                 \
+    msg->NAME.n_elements = (msg->NAME.data != NULL) ? args.size : 0;        \
+    for (uint32_t i = 0; i < msg->NAME.n_elements; i++){ fill_##TYPE(&msg->NAME.data[i]); }
+#define FILL_SRV(TYPE, NAME, HASH, REQ, REP)                                \
+    static inline void fill_request_##TYPE(request_##TYPE* msg){ REQ }      \
+    static inline void fill_reply_##TYPE(reply_##TYPE* msg){ REP }
+
+MSG_LIST(FILL_PROTO, FILL_PROTO, FILL_PROTO, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+MSG_LIST(FILL_BTYPE, FILL_CTYPE, FILL_BTYPE, FILL_FIELD, FILL_ARRAY, FILL_SEQUENCE)
+SRV_LIST_EXPAND(FILL_SRV, PS_EXPAND, PS_EXPAND, FILL_FIELD, FILL_ARRAY, FILL_SEQUENCE)
+
+/* ----- timing --------------------------------------------------------------*/
+
+static void report(const char* type, size_t len, bool ok, uint64_t ser_ns, uint64_t des_ns){
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < args.count; i++){
+        memcpy(check_buf, ser_buf, len);
+        CLOBBER(check_buf);
+    }
+    uint64_t copy_ns = bench_now_ns() - start;
+    double n = args.count;
+    bench_csv_row("serdes", "%s,%zu,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f,%.2f",
+                  type, len, ok,
+                  ser_ns / n, des_ns / n, copy_ns / n,
+                  len * n / (ser_ns ? ser_ns : 1) * 1e3,
+                  len * n / (des_ns ? des_ns : 1) * 1e3,
+                  (double)ser_ns / (copy_ns ? copy_ns : 1),
+                  (double)des_ns / (copy_ns ? copy_ns : 1));
+}
+
+// Destination is filled with the same seed so its sequences have the capacity of the source ones
+#define BENCH_TYPE(TYPE, ...)                                               \
+    static void bench_##TYPE(void){                                         \
+        static TYPE src, dst;                                               \
+        if (args.type != NULL && strcmp(args.type, #TYPE) != 0){            \
+            return;                                                         \
+        }                                                                   \
+        arena_used = 0;                                                     \
+        rng_state = 0x9e3779b97f4a7c15ull;                                  \
+        fill_##TYPE(&src);                                                  \
+        rng_state = 0x9e3779b97f4a7c15ull;                                  \
+        fill_##TYPE(&dst);                                                  \
+        size_t len = _ps_serialize(ser_buf, &src, SER_BUF_SIZE);            \
+        bool ok = len < SER_BUF_SIZE && _ps_deserialize(ser_buf, &dst, len); \
+        ok = ok && _ps_serialize(check_buf, &dst, SER_BUF_SIZE) == len &&   \
+             memcmp(ser_buf, check_buf, len) == 0;                          \
+        uint64_t t0 = bench_now_ns();                                       \
+        for (uint32_t i = 0; i < args.count; i++){                          \
+            _ps_serialize(ser_buf, &src, SER_BUF_SIZE);                     \
+            CLOBBER(ser_buf);                                               \
+        }                                                                   \
+        uint64_t t1 = bench_now_ns();                                       \
+        for (uint32_t i = 0; i < args.count; i++){                          \
+            _ps_deserialize(ser_buf, &dst, len);                            \
+            CLOBBER(&dst);                                                  \
+        }                                                                   \
+        uint64_t t2 = bench_now_ns();                                       \
+        report(#TYPE, len, ok, t1 - t0, t2 - t1);                          \
+    }
+#define BENCH_SRV(TYPE, ...)                                                \
+    BENCH_TYPE(request_##TYPE)                                              \
+    BENCH_TYPE(reply_##TYPE)
+
+MSG_LIST_EXPAND(PS_UNUSED, BENCH_TYPE, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+SRV_LIST_EXPAND(BENCH_SRV, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+
+#define CALL_BENCH(TYPE, ...)   bench_##TYPE();
+#define CALL_BENCH_SRV(TYPE, ...)                                           \
+    bench_request_##TYPE();                                                 \
+    bench_reply_##TYPE();
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    ser_buf = malloc(SER_BUF_SIZE);
+    check_buf = malloc(SER_BUF_SIZE);
+    arena = malloc(ARENA_SIZE);
+    for (uint32_t i = 0; i < 8; i++){
+        // lengths from empty to 42 characters
+        memset(strings[i], 'a' + i, i * 6);
+        strings[i][i * 6] = '\0';
+    }
+
+    bench_csv_header("type,bytes,ok,ser_ns,des_ns,memcpy_ns,ser_mb_per_s,des_mb_per_s,ser_x_memcpy,des_x_memcpy");
+    MSG_LIST_EXPAND(PS_UNUSED, CALL_BENCH, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+    SRV_LIST_EXPAND(CALL_BENCH_SRV, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * @file    bench_srv_call.c
+ * @brief   Service call CPU cost benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Calls the add two integers service of srv_server_add2ints example
+ *          with blocking calls, once issuing every request with z_get and once
+ *          through a querier declared at client init. Reports process CPU
+ *          time, heap allocations and round-trip time per call.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+static bench_args_t args = {
+    .ifx = {
+        .mode = "client",
+        .locator = "tcp/127.0.0.1:7447",
+    },
+    .count = 2000,
+    .period_us = 5000,  // 200 Hz command rate
+};
+
+#define CALL_TIMEOUT_MS 1000
+
+// Querier is declared with call timeout, so querier mode calls don't fall back to z_get
+#define ADD2_CLIENT(USE_GET) {                          \
+        .node_name = "picoros",                         \
+        .topic = {                                      \
+            .name = "services/add2",                    \
+            .type = ROSTYPE_NAME(srv_AddTwoInts),       \
+            .rihs_hash = ROSTYPE_HASH(srv_AddTwoInts),  \
+        },                                              \
+        .use_get = USE_GET,                             \
+        .timeout_ms = CALL_TIMEOUT_MS,                  \
+    }
+static picoros_srv_client_t get_client = ADD2_CLIENT(true);
+static picoros_srv_client_t querier_client = ADD2_CLIENT(false);
+
+static void run(const char* mode, picoros_srv_client_t* client){
+    uint8_t buf[64];
+    uint8_t reply_buf[64];
+    uint32_t failed = 0;
+    uint64_t rtt_ns = 0;
+    uint64_t call_cpu_ns = 0;
+
+    picoros_service_client_init(client);
+    picoalloc_stats_t start_alloc, end_alloc;
+    picoalloc_read(&start_alloc);
+    uint64_t start_cpu = bench_cpu_ns();
+    for (uint32_t i = 0; i < args.count; i++){
+        request_srv_AddTwoInts request = {.a = i, .b = 1};
+        size_t len = ps_serialize(buf, &request, sizeof(buf));
+        size_t reply_len = sizeof(reply_buf);
+
+        uint64_t t0 = bench_now_ns();
+        uint64_t c0 = bench_cpu_ns();
+        if (picoros_service_call_sync(client, buf, len, reply_buf, &reply_len, CALL_TIMEOUT_MS) != PICOROS_OK){
+            failed++;
+        }
+        call_cpu_ns += bench_cpu_ns() - c0;
+        rtt_ns += bench_now_ns() - t0;
+        if (args.period_us){
+            z_sleep_us(args.period_us);
+        }
+    }
+    picoalloc_read(&end_alloc);
+    uint64_t n = args.count;
+    bench_csv_row("srv_call", "%s,%" PRIu64 ",%" PRIu32 ",%.1f,%.1f,%.2f,%.1f",
+                  mode, n, failed,
+                  (double)call_cpu_ns / n / 1000.0,
+                  (double)(bench_cpu_ns() - start_cpu) / n / 1000.0,
+                  (double)(end_alloc.allocs - start_alloc.allocs) / n,
+                  (double)rtt_ns / n / 1000.0);
+}
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    bench_interface_init(&args);
+
+    bench_csv_header("mode,calls,failed,call_cpu_us,process_cpu_us_per_call,allocs_per_call,rtt_us");
+    run("get", &get_client);
+    run("querier", &querier_client);
+    return 0;
+}
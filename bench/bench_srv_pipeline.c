@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * @file    bench_srv_pipeline.c
+ * @brief   Pipelined service client throughput benchmark
+ * @date    2026-Oct-18
+ *
+ * @details Calls the add two integers service of srv_server_add2ints example
+ *          keeping a fixed number of requests in flight and reports requests
+ *          per second for each pipeline depth. Without "-d" depths 1 to 32
+ *          are swept.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <sched.h>
+#include "picoros.h"
+#include "picoserdes.h"
+#include "bench_common.h"
+
+#define MAX_DEPTH 64u
+
+static bench_args_t args = {
+    .ifx = {
+        .mode = "client",
+        .locator = "tcp/127.0.0.1:7447",
+    },
+    .count = 10000,
+};
+
+static void reply_cb(picoros_srv_client_t* client, uint8_t* reply_data, size_t reply_size, bool error);
+static void drop_cb(picoros_srv_client_t* client);
+
+static picoros_srv_slot_t slots[MAX_DEPTH];
+static picoros_srv_client_t client = {
+    .node_name = "picoros",
+    .topic = {
+        .name = "services/add2",
+        .type = ROSTYPE_NAME(srv_AddTwoInts),
+        .rihs_hash = ROSTYPE_HASH(srv_AddTwoInts),
+    },
+    .user_callback = reply_cb,
+    .drop_callback = drop_cb,
+    .slots = slots,
+};
+
+static volatile uint32_t completed;
+static uint32_t replies;
+static uint32_t errors;
+
+static void reply_cb(picoros_srv_client_t* client, uint8_t* reply_data, size_t reply_size, bool error){
+    reply_srv_AddTwoInts response = {};
+    if (error || !ps_deserialize(reply_data, &response, reply_size)){
+        errors++;
+        return;
+    }
+    replies++;
+}
+
+static void drop_cb(picoros_srv_client_t* client){
+    __atomic_fetch_add(&completed, 1, __ATOMIC_RELEASE);
+}
+
+static void run(uint32_t depth){
+    uint8_t buf[64];
+    uint32_t sent = 0;
+    completed = 0;
+    replies = 0;
+    errors = 0;
+    client.n_slots = depth;
+    picoros_service_client_init(&client);
+
+    uint64_t start = bench_now_ns();
+    while (__atomic_load_n(&completed, __ATOMIC_ACQUIRE) < args.count){
+        if (sent < args.count){
+            request_srv_AddTwoInts request = {.a = sent, .b = 1};
+            size_t len = ps_serialize(buf, &request, sizeof(buf));
+            if (picoros_service_call(&client, buf, len) == PICOROS_OK){
+                sent++;
+                continue;
+            }
+        }
+        sched_yield();
+    }
+    double elapsed_s = (double)(bench_now_ns() - start) / 1e9;
+    double rps = args.count / elapsed_s;
+    // Little's law, pipeline is kept full
+    bench_csv_row("srv_pipeline", "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%.0f,%.1f",
+                  depth, args.count, replies, errors, rps, depth / rps * 1e6);
+}
+
+int main(int argc, char** argv){
+    if (bench_parse_args(argc, argv, &args) != 0){
+        return 1;
+    }
+    if (args.depth > MAX_DEPTH){
+        fprintf(stderr, "Maximum depth is %u\n", MAX_DEPTH);
+        return 1;
+    }
+    bench_interface_init(&args);
+
+    bench_csv_header("depth,requests,replies,errors,requests_per_s,mean_latency_us");
+    if (args.depth != 0){
+        run(args.depth);
+        return 0;
+    }
+    for (uint32_t depth = 1; depth <= 32; depth *= 2){
+        run(depth);
+    }
+    return 0;
+}
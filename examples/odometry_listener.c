@@ -24,6 +24,15 @@ extern int picoros_parse_args(int argc, char **argv, picoros_interface_t* ifx);
 // Subscriber callback
 void odometry_callback(uint8_t* rx_data, size_t data_len);
 
+// Preallocated receive buffers, larger odometry messages are dropped
+uint8_t odo_pool_mem[2 * 1024];
+picoros_pool_t odo_pool = {
+    .mem = odo_pool_mem,
+    .buf_size = 1024,
+    .buf_count = 2,
+    .policy = PICOROS_POOL_DROP,
+};
+
 // Example Subscriber
 picoros_subscriber_t sub_odo = {
     .topic = {
@@ -32,6 +41,7 @@ picoros_subscriber_t sub_odo = {
         .rihs_hash = ROSTYPE_HASH(ros_Odometry),
     },
     .user_callback = odometry_callback,
+    .rx_pool = &odo_pool,
 };
 
 // Example node
@@ -21,6 +21,17 @@
 // Common utils
 extern int picoros_parse_args(int argc, char **argv, picoros_interface_t* ifx);
 
+// Publisher matching callback
+void odometry_matching(picoros_publisher_t* pub, bool matching);
+
+// Buffers loaned for publication, owned by transport while sending
+uint8_t pub_pool_mem[2 * 1024];
+picoros_pool_t pub_pool = {
+    .mem = pub_pool_mem,
+    .buf_size = 1024,
+    .buf_count = 2,
+};
+
 // Example Publisher
 picoros_publisher_t pub_odo = {
     .topic = {
@@ -28,6 +39,8 @@ picoros_publisher_t pub_odo = {
         .type = ROSTYPE_NAME(ros_Odometry),
         .rihs_hash = ROSTYPE_HASH(ros_Odometry),
     },
+    .tx_pool = &pub_pool,
+    .matching_callback = odometry_matching,
 };
 
 // Example node
@@ -35,10 +48,8 @@ picoros_node_t node = {
     .name = "picoros",
 };
 
-// Buffer for publication, used from this thread
-uint8_t pub_buf[1024];
-
-void publish_odometry(){
+// Serialize odometry, called only when a subscriber is listening
+size_t serialize_odometry(uint8_t* buf, size_t size, void* ctx){
     z_clock_t clk = z_clock_now();
     ros_Odometry odom = {
         .header = {
@@ -49,11 +60,15 @@ void publish_odometry(){
         .child_frame_id = "base-link",
     };
     printf("Publishing odometery...\n");
-    size_t len = ps_serialize(pub_buf, &odom, 1024);
-    if (len > 0){
-        picoros_publish(&pub_odo, pub_buf, len);
-    }
-    else{
+    return ps_serialize(buf, &odom, size);
+}
+
+void odometry_matching(picoros_publisher_t* pub, bool matching){
+    printf("Odometry subscribers %s\n", matching ? "matched" : "gone");
+}
+
+void publish_odometry(){
+    if (picoros_publish_serialized(&pub_odo, 1024, serialize_odometry, NULL) != PICOROS_OK){
         printf("Odometry message serialization error.");
     }
 }
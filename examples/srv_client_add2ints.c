@@ -4,7 +4,8 @@
  * @date    2025-Sept-2
  *
  * @details This example demonstrates a ROS service client implementation that
- *          calls an "add two integers" service and prints the result.
+ *          calls an "add two integers" service, waits for the reply and prints
+ *          the result with round-trip time.
  *
  * @copyright Copyright (c) 2025 Ubiquity Robotics
  *******************************************************************************/
@@ -21,9 +22,6 @@
 // Common utils
 extern int picoros_parse_args(int argc, char **argv,  picoros_interface_t* ifx);
 
-// Service reply callback
-void add2_client_cb(picoros_srv_client_t* client, uint8_t* reply_data, size_t reply_size,  bool error);
-
 // Example service
 picoros_srv_client_t add2_client = {
     .node_name = "picoros",
@@ -32,7 +30,7 @@ picoros_srv_client_t add2_client = {
         .type = ROSTYPE_NAME(srv_AddTwoInts),
         .rihs_hash = ROSTYPE_HASH(srv_AddTwoInts),
     },
-    .user_callback = add2_client_cb,
+    .timeout_ms = 2000,
     // .opts = &(z_get_options_t){
     //     .timeout_ms = 2000,
     //     .consolidation.mode = Z_CONSOLIDATION_MODE_MONOTONIC,
@@ -40,17 +38,6 @@ picoros_srv_client_t add2_client = {
     // },
 };
 
-void add2_client_cb(picoros_srv_client_t* client, uint8_t* reply_data, size_t reply_size,  bool error){
-    if (error){
-        printf("Service error reply recieved\n");
-        return;
-    }
-    reply_srv_AddTwoInts response = {};
-    ps_deserialize(reply_data, &response, reply_size);
-    printf("Got reply - sum: %ld\n", response.sum);
-}
-
-
 int main(int argc, char **argv){
     picoros_interface_t ifx = {
         .mode = MODE,
@@ -73,12 +60,25 @@ int main(int argc, char **argv){
     int b = 100;
     while(true){
         uint8_t buf[100];
-        request_srv_AddTwoInts request = {.a=a, b=b};
+        uint8_t reply_buf[100];
+        size_t reply_len = sizeof(reply_buf);
+        request_srv_AddTwoInts request = {.a=a, .b=b};
         size_t len = ps_serialize(buf, &request, 100);
-        if (picoros_service_call(&add2_client, buf, len) == PICOROS_OK){
-            printf("Sent service call...\n");
+
+        z_clock_t start = z_clock_now();
+        picoros_res_t res = picoros_service_call_sync(&add2_client, buf, len, reply_buf, &reply_len, 2000);
+        if (res == PICOROS_OK){
+            reply_srv_AddTwoInts response = {};
+            ps_deserialize(reply_buf, &response, reply_len);
+            printf("Got reply - sum: %ld in %lu us\n", response.sum, z_clock_elapsed_us(&start));
             a++;
         }
+        else if (res == PICOROS_TIMEOUT){
+            printf("Service call timed out\n");
+        }
+        else{
+            printf("Service call failed:%d\n", res);
+        }
         z_sleep_ms(100);
     }
     return 0;
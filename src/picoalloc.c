@@ -0,0 +1,301 @@
+/*******************************************************************************
+ * @file    picoalloc.c
+ * @brief   Pico-ROS allocation accounting
+ * @date    2026-Oct-18
+ *
+ * @details Link time wrappers of zenoh-pico heap functions. Wrappers hand out
+ *          the platform pointers unchanged and keep block sizes in a side
+ *          table, so blocks crossing between wrapped and unwrapped calls, e.g.
+ *          inside the platform layer object itself where --wrap does not
+ *          apply, stay valid. Frees of pointers missing from the table are
+ *          passed through uncounted.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+/* Private includes ----------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "zenoh-pico.h"
+#include "picoalloc.h"
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+ * @brief Size table entry of a live counted block
+ */
+typedef struct {
+    void*   ptr;                    /**< Block pointer, NULL if entry is free */
+    size_t  size;                   /**< Requested size */
+} alloc_block_t;
+
+/* Private define ------------------------------------------------------------*/
+#define BLOCKS_FILL_MAX (PICOALLOC_MAX_BLOCKS - PICOALLOC_MAX_BLOCKS / 4)
+#if Z_FEATURE_MULTI_THREAD == 1
+    #define THREAD_LOCAL _Thread_local
+#else
+    #define THREAD_LOCAL
+#endif
+/* Private macro -------------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+void* __real_z_malloc(size_t size);
+void* __real_z_realloc(void* ptr, size_t size);
+void __real_z_free(void* ptr);
+void* __wrap_z_malloc(size_t size);
+void* __wrap_z_realloc(void* ptr, size_t size);
+void __wrap_z_free(void* ptr);
+/* Private variables ---------------------------------------------------------*/
+static picoalloc_stats_t s_stats;
+static picoalloc_site_t s_sites[PICOALLOC_MAX_SITES];
+static picoalloc_violation_cb_t s_violation_cb;
+static alloc_block_t s_blocks[PICOALLOC_MAX_BLOCKS];
+static uint32_t s_block_count;
+static bool s_blocks_lock;
+static THREAD_LOCAL bool t_guarded;
+static THREAD_LOCAL bool t_strict;
+static THREAD_LOCAL uint32_t t_guard_allocs;
+/* Private functions ---------------------------------------------------------*/
+
+static void default_violation(const void* caller, size_t size) {
+    fprintf(stderr, "picoalloc: %zu byte allocation from %p in guarded region\n", size, caller);
+    abort();
+}
+
+// Find or claim site slot of caller, NULL if table is full
+static picoalloc_site_t* site_get(const void* caller) {
+    uint32_t idx = (uint32_t)(((uintptr_t)caller >> 2) * 2654435761u) % PICOALLOC_MAX_SITES;
+    for (uint32_t i = 0; i < PICOALLOC_MAX_SITES; i++) {
+        picoalloc_site_t* site = &s_sites[(idx + i) % PICOALLOC_MAX_SITES];
+        const void* cur = __atomic_load_n(&site->caller, __ATOMIC_ACQUIRE);
+        if (cur == caller) {
+            return site;
+        }
+        if (cur == NULL) {
+            if (__atomic_compare_exchange_n(&site->caller, &cur, caller, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) || cur == caller) {
+                return site;
+            }
+        }
+    }
+    return NULL;
+}
+
+static uint32_t size_bucket(size_t size) {
+    uint32_t bucket = 0;
+    while (bucket + 1 < PICOALLOC_SIZE_BUCKETS && ((size_t)1 << bucket) <= size) {
+        bucket++;
+    }
+    return bucket;
+}
+
+// Count allocation of size bytes, live is change of live bytes
+static void account_alloc(const void* caller, size_t size, int64_t live) {
+    __atomic_fetch_add(&s_stats.allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_stats.bytes, size, __ATOMIC_RELAXED);
+    uint64_t now = __atomic_add_fetch(&s_stats.live_bytes, (uint64_t)live, __ATOMIC_RELAXED);
+    uint64_t peak = __atomic_load_n(&s_stats.peak_bytes, __ATOMIC_RELAXED);
+    while (now > peak && !__atomic_compare_exchange_n(&s_stats.peak_bytes, &peak, now, true,
+                                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    picoalloc_site_t* site = site_get(caller);
+    if (site == NULL) {
+        __atomic_fetch_add(&s_stats.untracked, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        __atomic_fetch_add(&site->allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&site->bytes, size, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&site->size_hist[size_bucket(size)], 1, __ATOMIC_RELAXED);
+    }
+
+    if (t_guarded) {
+        t_guard_allocs++;
+        if (t_strict) {
+            picoalloc_violation_cb_t cb = __atomic_load_n(&s_violation_cb, __ATOMIC_ACQUIRE);
+            (cb ? cb : default_violation)(caller, size);
+        }
+    }
+}
+
+static void blocks_lock(void) {
+    while (__atomic_test_and_set(&s_blocks_lock, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+static void blocks_unlock(void) {
+    __atomic_clear(&s_blocks_lock, __ATOMIC_RELEASE);
+}
+
+static uint32_t block_hash(const void* ptr) {
+    return (uint32_t)(((uintptr_t)ptr >> 4) * 2654435761u) & (PICOALLOC_MAX_BLOCKS - 1);
+}
+
+// Table index of block, PICOALLOC_MAX_BLOCKS if missing, call with lock held
+static uint32_t block_find(const void* ptr) {
+    uint32_t idx = block_hash(ptr);
+    while (s_blocks[idx].ptr != NULL) {
+        if (s_blocks[idx].ptr == ptr) {
+            return idx;
+        }
+        idx = (idx + 1) & (PICOALLOC_MAX_BLOCKS - 1);
+    }
+    return PICOALLOC_MAX_BLOCKS;
+}
+
+// Remove entry and shift back later entries of its probe chain, call with lock held
+static void block_erase(uint32_t idx) {
+    uint32_t next = idx;
+    while (true) {
+        next = (next + 1) & (PICOALLOC_MAX_BLOCKS - 1);
+        if (s_blocks[next].ptr == NULL) {
+            break;
+        }
+        uint32_t home = block_hash(s_blocks[next].ptr);
+        // move entry unless its home lies cyclically in (idx, next]
+        if (((next - home) & (PICOALLOC_MAX_BLOCKS - 1)) >= ((next - idx) & (PICOALLOC_MAX_BLOCKS - 1))) {
+            s_blocks[idx] = s_blocks[next];
+            idx = next;
+        }
+    }
+    s_blocks[idx].ptr = NULL;
+    s_block_count--;
+}
+
+// Remove block from table, false if it was not counted
+static bool block_take(void* ptr, size_t* size) {
+    blocks_lock();
+    uint32_t idx = block_find(ptr);
+    bool found = idx < PICOALLOC_MAX_BLOCKS;
+    if (found) {
+        *size = s_blocks[idx].size;
+        block_erase(idx);
+    }
+    blocks_unlock();
+    return found;
+}
+
+// Record size of new block, returns change of live bytes
+static int64_t block_put(void* ptr, size_t size) {
+    int64_t live = (int64_t)size;
+    blocks_lock();
+    uint32_t idx = block_find(ptr);
+    if (idx < PICOALLOC_MAX_BLOCKS) {
+        // address reused, old block was freed by a call the wrappers did not see
+        live -= (int64_t)s_blocks[idx].size;
+        s_blocks[idx].size = size;
+    }
+    else if (s_block_count < BLOCKS_FILL_MAX) {
+        idx = block_hash(ptr);
+        while (s_blocks[idx].ptr != NULL) {
+            idx = (idx + 1) & (PICOALLOC_MAX_BLOCKS - 1);
+        }
+        s_blocks[idx].ptr = ptr;
+        s_blocks[idx].size = size;
+        s_block_count++;
+    }
+    else {
+        live = 0;
+        __atomic_fetch_add(&s_stats.unsized, 1, __ATOMIC_RELAXED);
+    }
+    blocks_unlock();
+    return live;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void* __wrap_z_malloc(size_t size) {
+    void* ptr = __real_z_malloc(size);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    account_alloc(__builtin_return_address(0), size, block_put(ptr, size));
+    return ptr;
+}
+
+void* __wrap_z_realloc(void* ptr, size_t size) {
+    size_t old_size = 0;
+    bool counted = ptr != NULL && block_take(ptr, &old_size);
+    void* new_ptr = __real_z_realloc(ptr, size);
+    if (new_ptr == NULL) {
+        if (counted) {
+            // old block is still live
+            block_put(ptr, old_size);
+        }
+        return NULL;
+    }
+    account_alloc(__builtin_return_address(0), size, block_put(new_ptr, size) - (int64_t)old_size);
+    return new_ptr;
+}
+
+void __wrap_z_free(void* ptr) {
+    size_t size;
+    if (ptr != NULL && block_take(ptr, &size)) {
+        __atomic_fetch_add(&s_stats.frees, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&s_stats.live_bytes, size, __ATOMIC_RELAXED);
+    }
+    __real_z_free(ptr);
+}
+
+void picoalloc_read(picoalloc_stats_t* out) {
+    out->allocs = __atomic_load_n(&s_stats.allocs, __ATOMIC_RELAXED);
+    out->frees = __atomic_load_n(&s_stats.frees, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&s_stats.bytes, __ATOMIC_RELAXED);
+    out->live_bytes = __atomic_load_n(&s_stats.live_bytes, __ATOMIC_RELAXED);
+    out->peak_bytes = __atomic_load_n(&s_stats.peak_bytes, __ATOMIC_RELAXED);
+    out->untracked = __atomic_load_n(&s_stats.untracked, __ATOMIC_RELAXED);
+    out->unsized = __atomic_load_n(&s_stats.unsized, __ATOMIC_RELAXED);
+}
+
+uint8_t picoalloc_sites(picoalloc_site_t* out, uint8_t max) {
+    uint8_t n = 0;
+    for (uint32_t i = 0; i < PICOALLOC_MAX_SITES && n < max; i++) {
+        picoalloc_site_t* site = &s_sites[i];
+        const void* caller = __atomic_load_n(&site->caller, __ATOMIC_ACQUIRE);
+        if (caller == NULL) {
+            continue;
+        }
+        out[n].caller = caller;
+        out[n].allocs = __atomic_load_n(&site->allocs, __ATOMIC_RELAXED);
+        out[n].bytes = __atomic_load_n(&site->bytes, __ATOMIC_RELAXED);
+        for (uint32_t b = 0; b < PICOALLOC_SIZE_BUCKETS; b++) {
+            out[n].size_hist[b] = __atomic_load_n(&site->size_hist[b], __ATOMIC_RELAXED);
+        }
+        n++;
+    }
+    return n;
+}
+
+void picoalloc_reset(void) {
+    __atomic_store_n(&s_stats.allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_stats.frees, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_stats.bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_stats.untracked, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_stats.unsized, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_stats.peak_bytes, __atomic_load_n(&s_stats.live_bytes, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < PICOALLOC_MAX_SITES; i++) {
+        picoalloc_site_t* site = &s_sites[i];
+        __atomic_store_n(&site->allocs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&site->bytes, 0, __ATOMIC_RELAXED);
+        for (uint32_t b = 0; b < PICOALLOC_SIZE_BUCKETS; b++) {
+            __atomic_store_n(&site->size_hist[b], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&site->caller, NULL, __ATOMIC_RELEASE);
+    }
+}
+
+void picoalloc_guard_begin(bool strict) {
+    t_guard_allocs = 0;
+    t_strict = strict;
+    t_guarded = true;
+}
+
+uint32_t picoalloc_guard_end(void) {
+    t_guarded = false;
+    return t_guard_allocs;
+}
+
+void picoalloc_set_violation_cb(picoalloc_violation_cb_t cb) {
+    __atomic_store_n(&s_violation_cb, cb, __ATOMIC_RELEASE);
+}
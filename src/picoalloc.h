@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * @file    picoalloc.h
+ * @brief   Pico-ROS allocation accounting
+ * @date    2026-Oct-18
+ *
+ * @details Wraps z_malloc, z_realloc and z_free of the zenoh-pico platform layer
+ *          at link time (-Wl,--wrap=...) to count allocations of picoros and
+ *          zenoh-pico per call site. Pointers are passed through unchanged,
+ *          block sizes for live bytes are kept in a table of
+ *          PICOALLOC_MAX_BLOCKS entries. Guarded regions catch heap allocations on
+ *          paths that should be allocation free once running.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#ifndef PICOALLOC_H_
+#define PICOALLOC_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+ /**
+ * @defgroup picoalloc picoalloc
+ * @{
+ */
+/** @} */
+
+/* Exported includes ---------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef PICOALLOC_MAX_SITES
+/** @brief Number of tracked allocation call sites @ingroup picoalloc */
+#define PICOALLOC_MAX_SITES 32u
+#endif
+#ifndef PICOALLOC_MAX_BLOCKS
+/** @brief Size table entries, power of two, at most three quarters of live blocks are sized @ingroup picoalloc */
+#define PICOALLOC_MAX_BLOCKS 4096u
+#endif
+#ifndef PICOALLOC_SIZE_BUCKETS
+/** @brief Number of power of two allocation size buckets per call site @ingroup picoalloc */
+#define PICOALLOC_SIZE_BUCKETS 16u
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief Process wide allocation counters
+ * @ingroup picoalloc
+ */
+typedef struct {
+    uint64_t allocs;                /**< Number of allocations, including reallocations */
+    uint64_t frees;                 /**< Number of frees of non NULL pointers */
+    uint64_t bytes;                 /**< Total allocated bytes */
+    uint64_t live_bytes;            /**< Currently allocated bytes */
+    uint64_t peak_bytes;            /**< High-water mark of live_bytes */
+    uint32_t untracked;             /**< Allocations from call sites beyond PICOALLOC_MAX_SITES */
+    uint32_t unsized;               /**< Allocations beyond size table, not in live_bytes and frees */
+} picoalloc_stats_t;
+
+/**
+ * @brief Allocation counters of one call site
+ * @ingroup picoalloc
+ */
+typedef struct {
+    const void* caller;             /**< Return address of z_malloc/z_realloc call, resolve with addr2line */
+    uint32_t    allocs;             /**< Number of allocations */
+    uint64_t    bytes;              /**< Total allocated bytes */
+    uint32_t    size_hist[PICOALLOC_SIZE_BUCKETS]; /**< Bucket i counts sizes below 2^i, last one all larger sizes */
+} picoalloc_site_t;
+
+/**
+ * @brief Handler of allocation inside strict guarded region
+ * @param caller Return address of allocation call
+ * @param size Requested size
+ * @ingroup picoalloc
+ */
+typedef void (*picoalloc_violation_cb_t)(const void* caller, size_t size);
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Take snapshot of process wide counters
+ * @param out Snapshot
+ * @ingroup picoalloc
+ */
+void picoalloc_read(picoalloc_stats_t* out);
+
+/**
+ * @brief Take snapshot of call site counters
+ * @param out Array receiving call sites
+ * @param max Size of out array
+ * @return Number of call sites written
+ * @ingroup picoalloc
+ */
+uint8_t picoalloc_sites(picoalloc_site_t* out, uint8_t max);
+
+/**
+ * @brief Clear counters and call sites, peak is restarted from live bytes
+ * @details Should not race with allocations from other threads.
+ * @ingroup picoalloc
+ */
+void picoalloc_reset(void);
+
+/**
+ * @brief Start guarded region on calling thread
+ * @details Allocations on the calling thread are counted until picoalloc_guard_end().
+ *          In strict mode every allocation also calls the violation handler.
+ * @param strict True to call violation handler on allocation
+ * @ingroup picoalloc
+ */
+void picoalloc_guard_begin(bool strict);
+
+/**
+ * @brief End guarded region on calling thread
+ * @return Number of allocations made inside region
+ * @ingroup picoalloc
+ */
+uint32_t picoalloc_guard_end(void);
+
+/**
+ * @brief Set violation handler of strict guarded regions
+ * @param cb Handler, NULL restores default which prints caller and aborts
+ * @ingroup picoalloc
+ */
+void picoalloc_set_violation_cb(picoalloc_violation_cb_t cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PICOALLOC_H_ */
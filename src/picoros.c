@@ -11,10 +11,17 @@
  *******************************************************************************/
 
 /* Private includes ----------------------------------------------------------*/
+#if defined(ZENOH_LINUX)
+    #define _GNU_SOURCE     // pthread_attr_setaffinity_np
+#endif
 #include <stddef.h>
 #include <string.h>
 #include <inttypes.h>
 #include "picoros.h"
+#include "picotrace.h"
+#if defined(ZENOH_LINUX)
+    #include <unistd.h>
+#endif
 
 #ifdef PICOROS_DEBUG
     #include <stdio.h>
@@ -23,13 +30,186 @@
     #define _PR_LOG(...)
 #endif
 /* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint8_t* buf;                       /**< Reply buffer */
+    size_t   size;                      /**< Size of reply buffer */
+    size_t   len;                       /**< Size of received reply */
+    bool     replied;                   /**< Reply received */
+    bool     error;                     /**< Error reply received */
+    bool     done;                      /**< Call completed */
+} sync_call_t;
+
+typedef struct {
+    uint32_t         len;               /**< Publication size */
+    rmw_attachment_t attachment;        /**< Attachment sent with publication */
+} cache_record_t;
+
+typedef struct picoros_intra_topic_s {
+    uint32_t              hash;         /**< Key expression hash */
+    char*                 keyexpr;      /**< Key expression, NULL if topic is free */
+    picoros_publisher_t*  pubs;         /**< Local intra_process publishers */
+    picoros_subscriber_t* subs;         /**< Local intra_process subscribers */
+    picoros_subscriber_t* shared;       /**< Subscribers sharing zsub */
+    z_owned_subscriber_t  zsub;         /**< Zenoh subscriber fanning out to shared list */
+    z_owned_liveliness_token_t token;   /**< Liveliness token of zsub */
+    bool                  has_token;    /**< token is declared */
+    picoros_session_t*    session;      /**< Session zsub is declared on */
+    bool                  zsub_busy;    /**< zsub is being declared or undeclared outside registry lock */
+    uint32_t              readers;      /**< Deliveries running on pubs, subs or shared list */
+} intra_topic_t;
 /* Private define ------------------------------------------------------------*/
+// Callbacks run from one subscriber queue before worker moves to next subscriber
+#define EXECUTOR_BUDGET 8u
+#if Z_FEATURE_MULTI_THREAD == 1
+    #define THREAD_LOCAL _Thread_local
+#else
+    #define THREAD_LOCAL
+#endif
 /* Private macro -------------------------------------------------------------*/
+// Session of an entity, NULL selects default session
+#define SESSION(s) ((s) != NULL ? (s) : &s_default)
+// Loaned zenoh session of an entity
+#define ZSESSION(s) z_session_loan(&SESSION(s)->zsession)
+// Synchronous service call lock of a client and publication cache lock, each has its own mutex
+#if Z_FEATURE_MULTI_THREAD == 1
+    #define SYNC_LOCK(c) z_mutex_lock(z_mutex_loan_mut(&(c)->_mutex))
+    #define SYNC_UNLOCK(c) z_mutex_unlock(z_mutex_loan_mut(&(c)->_mutex))
+    #define CACHE_LOCK(c) z_mutex_lock(z_mutex_loan_mut(&(c)->_mutex))
+    #define CACHE_UNLOCK(c) z_mutex_unlock(z_mutex_loan_mut(&(c)->_mutex))
+#else
+    #define SYNC_LOCK(c) (void)(c)
+    #define SYNC_UNLOCK(c) (void)(c)
+    #define CACHE_LOCK(c) (void)(c)
+    #define CACHE_UNLOCK(c) (void)(c)
+#endif
+// Run user callback, timed if entity has statistics and traced
+#define STATS_CALLBACK(st, call)                        \
+    do {                                                \
+        z_clock_t _start = stats_begin(st);             \
+        PICOTRACE_BEGIN(PICOTRACE_EV_CALLBACK, 0);      \
+        call;                                           \
+        PICOTRACE_END(PICOTRACE_EV_CALLBACK, 0);        \
+        stats_end(st, &_start);                         \
+    } while (0)
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-static z_owned_session_t s_wrapper;
+static picoros_session_t s_default;
+static intra_topic_t s_intra[PICOROS_INTRA_MAX_TOPICS];
+static bool s_intra_lock;
+static THREAD_LOCAL uint32_t* t_run_epoch;
+static THREAD_LOCAL uint8_t t_intra_readers[PICOROS_INTRA_MAX_TOPICS];
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
+// Claim lowest free bit of a usage bitmask, returns -1 if first count bits are used.
+// Count is clamped to mask width, e.g. for pools with user memory used without init.
+static int mask_claim(uint32_t* mask, uint8_t count) {
+    if (count > 32) {
+        count = 32;
+    }
+    uint32_t used = __atomic_load_n(mask, __ATOMIC_RELAXED);
+    for (;;) {
+        uint8_t i = 0;
+        while (i < count && (used & (1u << i))) {
+            i++;
+        }
+        if (i == count) {
+            return -1;
+        }
+        if (__atomic_compare_exchange_n(mask, &used, used | (1u << i), false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return i;
+        }
+    }
+}
+
+// Release bit claimed with mask_claim()
+static void mask_release(uint32_t* mask, uint32_t idx) {
+    __atomic_fetch_and(mask, ~(1u << idx), __ATOMIC_RELEASE);
+}
+
+static void stats_message(picoros_stats_t* st, size_t len) {
+    if (st != NULL) {
+        __atomic_fetch_add(&st->messages, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&st->bytes, len, __ATOMIC_RELAXED);
+    }
+}
+
+static void stats_drop(picoros_stats_t* st) {
+    if (st != NULL) {
+        __atomic_fetch_add(&st->dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void stats_alloc(picoros_stats_t* st) {
+    if (st != NULL) {
+        __atomic_fetch_add(&st->allocations, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Start time of callback, clock is only read for entities with statistics
+static z_clock_t stats_begin(picoros_stats_t* st) {
+    z_clock_t start;
+    if (st != NULL) {
+        start = z_clock_now();
+    }
+    else {
+        memset(&start, 0, sizeof(start));
+    }
+    return start;
+}
+
+// Add callback duration to statistics
+static void stats_end(picoros_stats_t* st, z_clock_t* start) {
+    if (st == NULL) {
+        return;
+    }
+    unsigned long us = z_clock_elapsed_us(start);
+    uint32_t duration = (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+    uint32_t bucket = (duration == 0) ? 0 : 32u - (uint32_t)__builtin_clz(duration);
+    if (bucket >= PICOROS_STATS_CB_BUCKETS) {
+        bucket = PICOROS_STATS_CB_BUCKETS - 1;
+    }
+    __atomic_fetch_add(&st->callback_hist[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&st->callbacks, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&st->callback_us, duration, __ATOMIC_RELAXED);
+    uint32_t max = __atomic_load_n(&st->callback_max_us, __ATOMIC_RELAXED);
+    while (duration > max &&
+           !__atomic_compare_exchange_n(&st->callback_max_us, &max, duration, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Get buffer for len bytes from pool or heap, returns NULL if message should be dropped.
+// Heap allocations and drops are counted in entity statistics st.
+static uint8_t* pool_get(picoros_pool_t* pool, size_t len, picoros_stats_t* st) {
+    if (pool == NULL) {
+        stats_alloc(st);
+        return (uint8_t*)z_malloc(len);
+    }
+    if (len <= pool->buf_size && pool->mem != NULL) {
+        int i = mask_claim(&pool->_used, pool->buf_count);
+        if (i >= 0) {
+            return pool->mem + i * pool->buf_size;
+        }
+    }
+    if (pool->policy == PICOROS_POOL_HEAP) {
+        __atomic_fetch_add(&pool->heap_fallbacks, 1, __ATOMIC_RELAXED);
+        stats_alloc(st);
+        return (uint8_t*)z_malloc(len);
+    }
+    __atomic_fetch_add(&pool->dropped, 1, __ATOMIC_RELAXED);
+    stats_drop(st);
+    return NULL;
+}
+
+// Return buffer to pool it was taken from or free heap buffer
+static void pool_put(picoros_pool_t* pool, uint8_t* buf) {
+    if (pool != NULL && buf >= pool->mem && buf < pool->mem + pool->buf_count * pool->buf_size) {
+        mask_release(&pool->_used, (uint32_t)((buf - pool->mem) / pool->buf_size));
+        return;
+    }
+    z_free(buf);
+}
+
 static void rmw_zenoh_gen_attachment_gid(rmw_attachment_t* attachment) {
     attachment->rmw_gid_size = RMW_GID_SIZE;
     for (int i = 0; i < RMW_GID_SIZE; i++) {
@@ -37,11 +217,20 @@ static void rmw_zenoh_gen_attachment_gid(rmw_attachment_t* attachment) {
     }
 }
 
+// Current time in nanoseconds since epoch, as rmw_zenoh stamps attachments
+static int64_t rmw_zenoh_time_ns(void) {
+    _z_time_since_epoch t;
+    if (_z_get_time_since_epoch(&t) != Z_OK) {
+        return 0;
+    }
+    return (int64_t)t.secs * 1000000000 + t.nanos;
+}
+
 static int rmw_zenoh_node_liveliness_keyexpr(picoros_node_t* node, char* keyexpr) {
 #if USE_NODE_GUID == 1
     uint8_t* guid = node->guid;
 #endif
-    z_id_t id = z_info_zid(z_session_loan(&s_wrapper));
+    z_id_t id = z_info_zid(ZSESSION(node->session));
     return snprintf(keyexpr, KEYEXPR_SIZE,
             "@ros2_lv/%" PRIu32 "/%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x/0/0/NN/%%/%%/"
 #if USE_NODE_GUID == 1
@@ -80,7 +269,49 @@ static int rmw_zenoh_service_keyexpr(picoros_node_t* node, rmw_topic_t* topic, c
     }
 }
 
-static int rmw_zenoh_topic_liveliness_keyexpr(picoros_node_t* node, rmw_topic_t* topic, char *keyexpr, const char *entity_str) {
+// Number field of QoS section, empty for rmw default
+static void rmw_zenoh_qos_field(char* field, uint32_t value) {
+    field[0] = 0;
+    if (value != 0) {
+        snprintf(field, 12, "%" PRIu32, value);
+    }
+}
+
+// QoS section of liveliness key expression, NULL qos is rmw default
+static void rmw_zenoh_qos_str(const picoros_qos_t* qos, char* str, size_t size) {
+    static const picoros_qos_t qos_default;
+    char reliability[12], durability[12], history[12], depth[12], deadline_s[12], deadline_ns[12];
+    qos = (qos != NULL) ? qos : &qos_default;
+    rmw_zenoh_qos_field(reliability, qos->reliability);
+    rmw_zenoh_qos_field(durability, qos->durability);
+    rmw_zenoh_qos_field(history, qos->history);
+    rmw_zenoh_qos_field(depth, qos->depth);
+    deadline_s[0] = deadline_ns[0] = 0;
+    if (qos->deadline_ms != 0) {
+        snprintf(deadline_s, sizeof(deadline_s), "%" PRIu32, qos->deadline_ms / 1000u);
+        snprintf(deadline_ns, sizeof(deadline_ns), "%" PRIu32, (qos->deadline_ms % 1000u) * 1000000u);
+    }
+    // reliability:durability:history,depth:deadline:lifespan:liveliness
+    snprintf(str, size, "%s:%s:%s,%s:%s,%s:,:,,", reliability, durability, history, depth, deadline_s, deadline_ns);
+}
+
+// Map QoS profile to zenoh publisher options, options of unset policies are kept
+static void qos_publisher_options(const picoros_qos_t* qos, z_publisher_options_t* options) {
+    // as rmw_zenoh, only reliable keep all history blocks publisher
+    if (qos->history == PICOROS_HISTORY_KEEP_ALL && qos->reliability != PICOROS_RELIABILITY_BEST_EFFORT) {
+        options->congestion_control = Z_CONGESTION_CONTROL_BLOCK;
+    }
+    else if (qos->history != PICOROS_HISTORY_DEFAULT || qos->reliability != PICOROS_RELIABILITY_DEFAULT) {
+        options->congestion_control = Z_CONGESTION_CONTROL_DROP;
+    }
+    if (qos->priority != 0) {
+        options->priority = qos->priority;
+        options->is_express = qos->priority <= Z_PRIORITY_INTERACTIVE_HIGH;
+    }
+}
+
+static int rmw_zenoh_topic_liveliness_keyexpr(picoros_node_t* node, rmw_topic_t* topic, char *keyexpr, const char *entity_str,
+                                              const picoros_qos_t* qos) {
 #if USE_NODE_GUID == 1
     uint8_t* guid = node->guid;
 #endif
@@ -88,7 +319,9 @@ static int rmw_zenoh_topic_liveliness_keyexpr(picoros_node_t* node, rmw_topic_t*
     topic_lv[TOPIC_MAX_NAME-1] = 0;
     char *str = &topic_lv[0];
 
-    z_id_t id = z_info_zid(z_session_loan(&s_wrapper));
+    z_id_t id = z_info_zid(ZSESSION(node->session));
+    char qos_str[80];
+    rmw_zenoh_qos_str(qos, qos_str, sizeof(qos_str));
 
     if (strcmp(entity_str, "SS") == 0 && node->name != NULL){
         // is service and node name is set
@@ -115,7 +348,7 @@ static int rmw_zenoh_topic_liveliness_keyexpr(picoros_node_t* node, rmw_topic_t*
             "0/11/%s/%%/%%/%s/%%%s/"
 #endif
             "%s_/RIHS01_%s"
-            "/::,:,:,:,,",
+            "/%s",
             node->domain_id,
             id.id[0], id.id[1],  id.id[2], id.id[3], id.id[4], id.id[5], id.id[6],
             id.id[7], id.id[8],  id.id[9], id.id[10], id.id[11], id.id[12], id.id[13],
@@ -127,266 +360,1973 @@ static int rmw_zenoh_topic_liveliness_keyexpr(picoros_node_t* node, rmw_topic_t*
             guid[8], guid[9], guid[10], guid[11],
             guid[12], guid[13], guid[14], guid[15],
 #endif
-            topic_lv, topic->type, topic->rihs_hash
+            topic_lv, topic->type, topic->rihs_hash, qos_str
                );
 
    return ret;
 }
 
-static void sub_data_handler(z_loaned_sample_t *sample, void *ctx) {
-    const z_loaned_bytes_t *b = z_sample_payload(sample);
-
-    size_t raw_data_len = _z_bytes_len(b);
-    if (raw_data_len == 0) {
+// Init payload view, data is used if already contiguous, b can be NULL if data is set
+static void rx_view_init(picoros_rx_view_t* view, const z_loaned_bytes_t* b, uint8_t* data, size_t len,
+                         const picoros_sample_info_t* info) {
+    view->data = data;
+    view->len = len;
+    view->info = info;
+    if (b == NULL) {
         return;
     }
-    uint8_t *raw_data = (uint8_t*)z_malloc(raw_data_len);
-    _z_bytes_to_buf(b, raw_data, raw_data_len);
+    view->_it = z_bytes_get_slice_iterator(b);
 
-    // Call user callback function if given:
-    if (ctx != NULL) {
-    	((picoros_sub_cb_t)ctx)(raw_data, raw_data_len);
+    // Single slice payload can be borrowed directly
+    z_bytes_slice_iterator_t it = view->_it;
+    z_view_slice_t slice;
+    if (data == NULL && z_bytes_slice_iterator_next(&it, &slice) && z_slice_len(z_view_slice_loan(&slice)) == len) {
+        view->data = (uint8_t*)z_slice_data(z_view_slice_loan(&slice));
     }
-    z_free(raw_data);
 }
 
-static void queriable_data_handler(z_loaned_query_t *query, void *arg) {
-    picoros_srv_server_t* srv = (picoros_srv_server_t*)arg;
+// Wake an idle executor worker
+static void executor_notify(picoros_executor_t* ex) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (__atomic_load_n(&ex->_idle, __ATOMIC_SEQ_CST) > 0) {
+        z_mutex_lock(z_mutex_loan_mut(&ex->_mutex));
+        z_condvar_signal(z_condvar_loan_mut(&ex->_cond));
+        z_mutex_unlock(z_mutex_loan_mut(&ex->_mutex));
+    }
+#endif
+}
 
-    if (srv->user_callback == NULL){
+// Copy sample to subscriber queue, called from read task which is the only producer
+static void sub_enqueue(picoros_subscriber_t* sub, const z_loaned_bytes_t* b, size_t len,
+                        const picoros_sample_info_t* info) {
+    picoros_sub_queue_t* q = sub->queue;
+    uint32_t head = q->_head;
+    uint32_t tail = __atomic_load_n(&q->_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= q->depth && q->policy == PICOROS_QUEUE_DROP_NEWEST) {
+        __atomic_fetch_add(&q->dropped, 1, __ATOMIC_RELAXED);
+        stats_drop(sub->stats);
         return;
     }
 
-    const z_loaned_bytes_t *b = z_query_payload(query);
-    size_t rx_data_len = _z_bytes_len(b);
+    // drop oldest before taking buffer, it may hold the last free one. Consumer may take it first
+    while (head - tail >= q->depth) {
+        uint8_t* old = __atomic_load_n(&q->entries[tail & (q->depth - 1)].data, __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&q->_tail, &tail, tail + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            __atomic_fetch_add(&q->dropped, 1, __ATOMIC_RELAXED);
+            stats_drop(sub->stats);
+            pool_put(sub->rx_pool, old);
+            tail++;
+        }
+    }
+    uint8_t* buf = pool_get(sub->rx_pool, len, sub->stats);
+    if (buf == NULL) {
+        __atomic_fetch_add(&q->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    _z_bytes_to_buf(b, buf, len);
+    picoros_queue_entry_t* e = &q->entries[head & (q->depth - 1)];
+    __atomic_store_n(&e->data, buf, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->len, len, __ATOMIC_RELAXED);
+    e->has_info = (info != NULL);
+    if (info != NULL) {
+        e->info = *info;
+    }
+    __atomic_store_n(&q->_head, head + 1, __ATOMIC_SEQ_CST);
+    executor_notify(sub->executor);
+}
 
-    // get request data
-    uint8_t* rx_data = (uint8_t*)z_malloc(rx_data_len);
-    _z_bytes_to_buf(b, rx_data, rx_data_len);
+// Run callback for queued sample and release its buffer
+static void sub_dispatch(picoros_subscriber_t* sub, uint8_t* data, size_t len, const picoros_sample_info_t* info) {
+    if (sub->view_callback != NULL) {
+        picoros_rx_view_t view;
+        rx_view_init(&view, NULL, data, len, info);
+        STATS_CALLBACK(sub->stats, sub->view_callback(sub, &view));
+    }
+    else if (sub->user_callback != NULL) {
+        STATS_CALLBACK(sub->stats, sub->user_callback(data, len));
+    }
+    pool_put(sub->rx_pool, data);
+}
 
-    // process
-    picoros_service_reply_t reply = srv->user_callback(srv, rx_data, rx_data_len);
+// Run up to budget queued callbacks of a subscriber unless another worker is running them
+static uint32_t sub_drain(picoros_subscriber_t* sub, uint32_t budget) {
+    picoros_sub_queue_t* q = sub->queue;
+    bool idle = false;
+    if (!__atomic_compare_exchange_n(&q->_busy, &idle, true, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    uint32_t n = 0;
+    while (n < budget) {
+        uint32_t tail = __atomic_load_n(&q->_tail, __ATOMIC_ACQUIRE);
+        if (tail == __atomic_load_n(&q->_head, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        picoros_queue_entry_t* e = &q->entries[tail & (q->depth - 1)];
+        uint8_t* data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+        size_t len = __atomic_load_n(&e->len, __ATOMIC_RELAXED);
+        picoros_sample_info_t info = e->info;
+        bool has_info = e->has_info;
+        if (!__atomic_compare_exchange_n(&q->_tail, &tail, tail + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            continue; // dropped by producer
+        }
+        sub_dispatch(sub, data, len, has_info ? &info : NULL);
+        n++;
+    }
+    __atomic_store_n(&q->_busy, false, __ATOMIC_RELEASE);
+    return n;
+}
 
-    if (reply.data) {
-        // move reply to zbytes
-        z_owned_bytes_t reply_payload;
-        z_bytes_copy_from_buf(&reply_payload, reply.data, reply.length);
+// Run queued callbacks, subscribers of this worker first, then steal from others.
+// Epoch of the runner is odd while it may hold subscriber pointers, see executor_remove().
+static uint32_t executor_run(picoros_executor_t* ex, uint32_t* epoch, uint8_t worker, uint8_t n_workers) {
+    __atomic_fetch_add(epoch, 1, __ATOMIC_SEQ_CST);
+    uint32_t* outer_epoch = t_run_epoch;
+    t_run_epoch = epoch;
+    uint32_t n = 0;
+    uint8_t n_subs = __atomic_load_n(&ex->_n_subs, __ATOMIC_ACQUIRE);
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t i = 0; i < n_subs; i++) {
+            if ((i % n_workers == worker) != (pass == 0)) {
+                continue;
+            }
+            picoros_subscriber_t* sub = __atomic_load_n(&ex->_subs[i], __ATOMIC_SEQ_CST);
+            if (sub != NULL) {
+                n += sub_drain(sub, EXECUTOR_BUDGET);
+            }
+        }
+    }
+    t_run_epoch = outer_epoch;
+    __atomic_fetch_add(epoch, 1, __ATOMIC_RELEASE);
+    return n;
+}
 
-        // rmw attachment
-        srv->attachment.sequence_number = 1;
-        srv->attachment.time = z_clock_now().tv_nsec;
-        z_query_reply_options_t options;
-        z_query_reply_options_default(&options);
-        z_owned_bytes_t tx_attachment;
-        z_bytes_from_static_buf(&tx_attachment, (uint8_t*)&srv->attachment, sizeof(rmw_attachment_t));
-        options.attachment = z_bytes_move(&tx_attachment);
+// Add subscriber to executor
+static picoros_res_t executor_add(picoros_executor_t* ex, picoros_subscriber_t* sub) {
+    picoros_sub_queue_t* q = sub->queue;
+    if (q == NULL || q->entries == NULL || q->depth == 0 || (q->depth & (q->depth - 1)) != 0) {
+        _PR_LOG("Subscriber queue depth must be power of two!\n");
+        return PICOROS_ERROR;
+    }
+    q->_head = 0;
+    q->_tail = 0;
+    q->_busy = false;
+    for (uint8_t i = 0; i < PICOROS_EXECUTOR_MAX_SUBS; i++) {
+        picoros_subscriber_t* free_entry = NULL;
+        if (__atomic_compare_exchange_n(&ex->_subs[i], &free_entry, sub, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            uint8_t n_subs = __atomic_load_n(&ex->_n_subs, __ATOMIC_RELAXED);
+            while (n_subs < i + 1 && !__atomic_compare_exchange_n(&ex->_n_subs, &n_subs, i + 1, false,
+                                                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            }
+            return PICOROS_OK;
+        }
+    }
+    _PR_LOG("Too many executor subscribers!\n");
+    return PICOROS_ERROR;
+}
 
-        // send reply
-        z_result_t res = z_query_reply(query, z_query_keyexpr(query), z_bytes_move(&reply_payload), &options);
-        if (res != Z_OK) {
-            _PR_LOG("Error sending service reply. Error:%d\n", res);
+// Remove subscriber from executor, waits for runners that may still use it and frees queued samples
+static void executor_remove(picoros_executor_t* ex, picoros_subscriber_t* sub) {
+    for (uint8_t i = 0; i < PICOROS_EXECUTOR_MAX_SUBS; i++) {
+        if (__atomic_load_n(&ex->_subs[i], __ATOMIC_RELAXED) == sub) {
+            __atomic_store_n(&ex->_subs[i], NULL, __ATOMIC_SEQ_CST);
+        }
+    }
+    // runner inside executor_run() may have loaded sub before it was unlinked, wait until it leaves.
+    // Calling runner is skipped, callback can remove its own subscriber
+    for (uint8_t i = 0; i < PICOROS_MAX_WORKERS + 1; i++) {
+        if (&ex->_epochs[i] == t_run_epoch) {
+            continue;
+        }
+        uint32_t epoch = __atomic_load_n(&ex->_epochs[i], __ATOMIC_SEQ_CST);
+        while ((epoch & 1u) != 0 && __atomic_load_n(&ex->_epochs[i], __ATOMIC_ACQUIRE) == epoch) {
+            z_sleep_ms(1);
         }
+    }
+    picoros_sub_queue_t* q = sub->queue;
+    while (q->_tail != q->_head) {
+        pool_put(sub->rx_pool, q->entries[q->_tail & (q->depth - 1)].data);
+        q->_tail++;
+    }
+}
 
-        // cleanup
-        z_bytes_drop(z_bytes_move(&reply_payload));
-        if (reply.free_callback != NULL) {
-            reply.free_callback(reply.data);
+#if Z_FEATURE_MULTI_THREAD == 1
+// Check if any subscriber queue has samples, epoch is marked as in executor_run()
+static bool executor_has_work(picoros_executor_t* ex, uint32_t* epoch) {
+    bool work = false;
+    __atomic_fetch_add(epoch, 1, __ATOMIC_SEQ_CST);
+    uint8_t n_subs = __atomic_load_n(&ex->_n_subs, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < n_subs && !work; i++) {
+        picoros_subscriber_t* sub = __atomic_load_n(&ex->_subs[i], __ATOMIC_SEQ_CST);
+        work = sub != NULL && __atomic_load_n(&sub->queue->_head, __ATOMIC_SEQ_CST)
+                           != __atomic_load_n(&sub->queue->_tail, __ATOMIC_SEQ_CST);
+    }
+    __atomic_fetch_add(epoch, 1, __ATOMIC_RELEASE);
+    return work;
+}
+
+// Executor worker thread
+static void* executor_task(void* arg) {
+    picoros_executor_t* ex = (picoros_executor_t*)arg;
+    uint8_t worker = __atomic_fetch_add(&ex->_started, 1, __ATOMIC_RELAXED);
+    uint32_t* epoch = &ex->_epochs[worker];
+    while (__atomic_load_n(&ex->_running, __ATOMIC_ACQUIRE)) {
+        if (executor_run(ex, epoch, worker, ex->n_workers) > 0) {
+            continue;
+        }
+        // sleep until producer sees this worker idle and signals
+        z_mutex_lock(z_mutex_loan_mut(&ex->_mutex));
+        __atomic_fetch_add(&ex->_idle, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&ex->_running, __ATOMIC_ACQUIRE) && !executor_has_work(ex, epoch)) {
+            z_condvar_wait(z_condvar_loan_mut(&ex->_cond), z_mutex_loan_mut(&ex->_mutex));
         }
+        __atomic_fetch_sub(&ex->_idle, 1, __ATOMIC_SEQ_CST);
+        z_mutex_unlock(z_mutex_loan_mut(&ex->_mutex));
     }
-    z_free(rx_data);
+    return NULL;
 }
+#endif
 
-static void queriable_drop_handler(void* arg) { _PR_LOG("Drop srv callback\n"); }
+// Check ingress rate limit, returns true if sample should be dropped. Read task and
+// local publishers can check it concurrently.
+static bool throttle_drop(picoros_throttle_t* t) {
+    uint32_t count = __atomic_fetch_add(&t->_count, 1, __ATOMIC_RELAXED);
+    if (t->every_nth > 1 && count % t->every_nth != 0) {
+        __atomic_fetch_add(&t->dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+    if (t->min_period_us != 0) {
+        bool drop = false;
+        while (__atomic_test_and_set(&t->_lock, __ATOMIC_ACQUIRE)) {
+        }
+        if (count != 0 && z_clock_elapsed_us(&t->_last) < t->min_period_us) {
+            drop = true;
+        }
+        else {
+            t->_last = z_clock_now();
+        }
+        __atomic_clear(&t->_lock, __ATOMIC_RELEASE);
+        if (drop) {
+            __atomic_fetch_add(&t->dropped, 1, __ATOMIC_RELAXED);
+        }
+        return drop;
+    }
+    return false;
+}
 
-static void get_drop_handler(void* ctx){
-    picoros_srv_client_t* client = (picoros_srv_client_t*)ctx;
-    client->_in_progress = false;
-    if(client->drop_callback != NULL){
-        client->drop_callback(client);
+// Overwrite oldest mailbox slot with sample, caller is the only writer
+static void mailbox_put(picoros_mailbox_t* mb, const z_loaned_bytes_t* b, size_t len) {
+    if (len > mb->buf_size) {
+        mb->oversize++;
+        return;
     }
+    uint32_t written = mb->_written;
+    if (written != __atomic_load_n(&mb->_taken, __ATOMIC_RELAXED) && written != 0) {
+        mb->overwritten++;
+    }
+    uint8_t slot = written % mb->n_slots;
+    __atomic_store_n(&mb->_seq[slot], mb->_seq[slot] + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    _z_bytes_to_buf(b, mb->mem + slot * mb->buf_size, len);
+    __atomic_store_n(&mb->_len[slot], len, __ATOMIC_RELAXED);
+    __atomic_store_n(&mb->_seq[slot], mb->_seq[slot] + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&mb->_written, written + 1, __ATOMIC_RELEASE);
 }
 
-static void get_data_handler(z_loaned_reply_t *reply, void *ctx){
-    if (ctx == NULL){
+// Hand payload to subscriber, data is set for contiguous local publications
+static void sub_deliver(picoros_subscriber_t* sub, const z_loaned_bytes_t* b, uint8_t* data, size_t len,
+                        const picoros_sample_info_t* info) {
+    if (sub->mailbox != NULL || sub->executor != NULL) {
+        // mailbox and queue have a single writer, local publishers take turns with read task
+        bool lock = sub->_intra != NULL;
+        while (lock && __atomic_test_and_set(&sub->_rx_lock, __ATOMIC_ACQUIRE)) {
+        }
+        if (sub->mailbox != NULL) {
+            mailbox_put(sub->mailbox, b, len); // Keep only latest sample, no callback
+        }
+        else {
+            sub_enqueue(sub, b, len, info); // Queue to executor, callbacks run on its workers
+        }
+        if (lock) {
+            __atomic_clear(&sub->_rx_lock, __ATOMIC_RELEASE);
+        }
         return;
     }
-    size_t raw_data_len = 0;
-    uint8_t* raw_data  = 0;
-    bool error = false;
-    const z_loaned_sample_t* sample = 0;
-    const z_loaned_bytes_t* payload = 0;
-    const z_loaned_reply_err_t* err = 0;
 
-    if (z_reply_is_ok(reply)) {
-        sample = z_reply_ok(reply);
-        payload = z_sample_payload(sample);
+    // Zero-copy path, payload is only borrowed for the duration of callback
+    if (sub->view_callback != NULL) {
+        picoros_rx_view_t view;
+        rx_view_init(&view, b, data, len, info);
+        STATS_CALLBACK(sub->stats, sub->view_callback(sub, &view));
+        return;
     }
-    else {
-        err = z_reply_err(reply);
-        payload = z_reply_err_payload(err);
-        error = true;
+
+    // Call user callback function if given:
+    if (sub->user_callback != NULL) {
+        if (data != NULL) {
+            STATS_CALLBACK(sub->stats, sub->user_callback(data, len));
+            return;
+        }
+        uint8_t *raw_data = pool_get(sub->rx_pool, len, sub->stats);
+        if (raw_data == NULL) {
+            return;
+        }
+        _z_bytes_to_buf(b, raw_data, len);
+        STATS_CALLBACK(sub->stats, sub->user_callback(raw_data, len));
+        pool_put(sub->rx_pool, raw_data);
     }
+}
 
-    raw_data_len = _z_bytes_len(payload);
-    if (raw_data_len == 0) {
-        return;
+static void seq_lock(picoros_seq_tracker_t* tr) {
+    while (__atomic_test_and_set(&tr->_lock, __ATOMIC_ACQUIRE)) {
     }
-    raw_data = (uint8_t*)z_malloc(raw_data_len);
-    _z_bytes_to_buf(payload, raw_data, raw_data_len);
+}
 
-    picoros_srv_client_t* client = (picoros_srv_client_t*)ctx;
-    client->user_callback(client, raw_data, raw_data_len, error);
-    z_free(raw_data);
+static void seq_unlock(picoros_seq_tracker_t* tr) {
+    __atomic_clear(&tr->_lock, __ATOMIC_RELEASE);
 }
 
-/* Public functions ----------------------------------------------------------*/
+// Count gaps, duplicates and late arrivals in sequence numbers of sample publisher
+static void seq_track(picoros_seq_tracker_t* tr, const picoros_sample_info_t* info) {
+    seq_lock(tr);
+    picoros_seq_stats_t* st = NULL;
+    for (uint8_t i = 0; info != NULL && i < tr->_count; i++) {
+        if (memcmp(tr->publishers[i].gid, info->publisher_gid, RMW_GID_SIZE) == 0) {
+            st = &tr->publishers[i];
+            break;
+        }
+    }
+    if (st == NULL) {
+        if (info == NULL || tr->_count >= PICOROS_SEQ_MAX_PUBLISHERS) {
+            tr->untracked++;
+        }
+        else {
+            // first sample of publisher, earlier ones were sent before we joined
+            st = &tr->publishers[tr->_count++];
+            memcpy(st->gid, info->publisher_gid, RMW_GID_SIZE);
+            st->last_seq = info->sequence_number;
+            st->received = 1;
+            st->_window = 1;
+        }
+        seq_unlock(tr);
+        return;
+    }
 
-picoros_res_t picoros_interface_init(picoros_interface_t* ifx) {
-    z_result_t res = Z_OK;
-    z_owned_config_t config;
-    z_config_default(&config);
+    st->received++;
+    int64_t diff = info->sequence_number - st->last_seq;
+    if (diff > 0) {
+        st->lost += (diff - 1 > UINT32_MAX) ? UINT32_MAX : (uint32_t)(diff - 1);
+        st->_window = (diff >= 64) ? 1 : (st->_window << diff) | 1;
+        st->last_seq = info->sequence_number;
+    }
+    else if (-diff < 64 && (st->_window >> -diff) & 1) {
+        st->duplicates++;
+    }
+    else {
+        if (-diff < 64) {
+            st->_window |= (uint64_t)1 << -diff;
+        }
+        st->reordered++;
+        if (st->lost > 0) {
+            st->lost--;
+        }
+    }
+    seq_unlock(tr);
+}
 
-    _PR_LOG("Configuring Zenoh session...\r\n");
-    zp_config_insert(z_config_loan_mut(&config), Z_CONFIG_MODE_KEY, ifx->mode);
-    if (ifx->locator) {
-        if (strcmp(ifx->mode, "client") == 0) {
-            zp_config_insert(z_config_loan_mut(&config), Z_CONFIG_CONNECT_KEY, ifx->locator);
+// Apply subscriber throttle and filter, true if payload is accepted.
+// Latency of accepted samples is recorded before any copy or callback.
+static bool sub_accept(picoros_subscriber_t* sub, const z_loaned_bytes_t* b, uint8_t* data, size_t len,
+                       const picoros_sample_info_t* info) {
+    if (sub->seq_tracker != NULL) {
+        seq_track(sub->seq_tracker, info);
+    }
+    if (sub->throttle != NULL && throttle_drop(sub->throttle)) {
+        stats_drop(sub->stats);
+        return false;
+    }
+    if (sub->filter != NULL) {
+        picoros_rx_view_t view;
+        rx_view_init(&view, b, data, len, info);
+        if (!sub->filter(sub, &view)) {
+            stats_drop(sub->stats);
+            return false;
+        }
+    }
+    stats_message(sub->stats, len);
+    if (sub->latency != NULL && info != NULL) {
+        int64_t latency_ns = rmw_zenoh_time_ns() - info->source_timestamp;
+        if (latency_ns < 0) {
+            __atomic_fetch_add(&sub->latency->skewed, 1, __ATOMIC_RELAXED);
         }
         else {
-            zp_config_insert(z_config_loan_mut(&config), Z_CONFIG_LISTEN_KEY, ifx->locator);
+            uint64_t latency_us = (uint64_t)latency_ns / 1000u;
+            picoros_latency_record(sub->latency, latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us);
         }
     }
+    return true;
+}
 
-    _PR_LOG("Opening Zenoh session...\r\n");
-    if ((res = z_open(&s_wrapper, z_config_move(&config), NULL)) != Z_OK) {
-        _PR_LOG("Unable to open Zenoh session! Error:%d\n", res);
-        return PICOROS_NOT_READY;
+// Read rmw attachment of sample without allocating, returns NULL if sample has none
+static const picoros_sample_info_t* sample_info_parse(const z_loaned_sample_t* sample, picoros_sample_info_t* info) {
+    const z_loaned_bytes_t* rx_attachment = z_sample_attachment(sample);
+    if (rx_attachment == NULL || _z_bytes_len(rx_attachment) != sizeof(rmw_attachment_t)) {
+        return NULL;
     }
-    _PR_LOG("Zenoh setup finished!\r\n");
+    rmw_attachment_t attachment;
+    _z_bytes_to_buf(rx_attachment, (uint8_t*)&attachment, sizeof(rmw_attachment_t));
+    info->sequence_number = attachment.sequence_number;
+    info->source_timestamp = attachment.time;
+    memcpy(info->publisher_gid, attachment.rmw_gid, RMW_GID_SIZE);
+    return info;
+}
 
-    // Start read and lease tasks for zenoh-pico
-    if((res = zp_start_read_task(z_session_loan_mut(&s_wrapper), NULL)) != Z_OK
-    || (res = zp_start_lease_task(z_session_loan_mut(&s_wrapper), NULL)) != Z_OK
-    ){
-        z_session_drop(z_session_move(&s_wrapper));
-        _PR_LOG("Failed to start read/lease tasks! Error:%d\n", res);
-        return PICOROS_ERROR;
+// Registry of intra-process and shared subscriptions
+static void intra_lock(void) {
+    while (__atomic_test_and_set(&s_intra_lock, __ATOMIC_ACQUIRE)) {
+        z_sleep_us(1);
     }
+}
 
-    return PICOROS_OK;
+static void intra_unlock(void) {
+    __atomic_clear(&s_intra_lock, __ATOMIC_RELEASE);
 }
 
-picoros_res_t picoros_node_init(picoros_node_t* node) {
-    z_result_t res = Z_OK;
-    char keyexpr[KEYEXPR_SIZE];
+// FNV-1a hash of key expression
+static uint32_t keyexpr_hash(const char* keyexpr, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)keyexpr[i]) * 16777619u;
+    }
+    return hash;
+}
 
-    rmw_zenoh_node_liveliness_keyexpr(node, keyexpr);
-    z_view_keyexpr_t ke;
+// Find or add registry topic, call with registry locked
+static intra_topic_t* intra_topic(const char* keyexpr) {
+    uint32_t hash = keyexpr_hash(keyexpr, strlen(keyexpr));
+    intra_topic_t* free_topic = NULL;
+    for (uint32_t i = 0; i < PICOROS_INTRA_MAX_TOPICS; i++) {
+        intra_topic_t* t = &s_intra[i];
+        if (t->keyexpr == NULL) {
+            free_topic = (free_topic == NULL) ? t : free_topic;
+        }
+        else if (t->hash == hash && strcmp(t->keyexpr, keyexpr) == 0) {
+            return t;
+        }
+    }
+    if (free_topic == NULL) {
+        _PR_LOG("Topic registry full\n");
+        return NULL;
+    }
+    size_t len = strlen(keyexpr) + 1;
+    if ((free_topic->keyexpr = (char*)z_malloc(len)) == NULL) {
+        return NULL;
+    }
+    memcpy(free_topic->keyexpr, keyexpr, len);
+    free_topic->hash = hash;
+    return free_topic;
+}
 
-    z_view_keyexpr_from_str(&ke, keyexpr);
+// Free registry topic once nothing is linked to it, call with registry locked
+static void intra_topic_release(intra_topic_t* t) {
+    if (t->pubs == NULL && t->subs == NULL && t->shared == NULL && !t->zsub_busy && t->keyexpr != NULL) {
+        z_free(t->keyexpr);
+        t->keyexpr = NULL;
+    }
+}
 
-    z_owned_liveliness_token_t token;
+// Start delivery reading lists of registry topic, also counted per thread
+static void intra_read_begin(intra_topic_t* t) {
+    t_intra_readers[t - s_intra]++;
+    __atomic_fetch_add(&t->readers, 1, __ATOMIC_SEQ_CST);
+}
 
-    if ((res = z_liveliness_declare_token(z_session_loan(&s_wrapper), &token, z_view_keyexpr_loan(&ke), NULL)) != Z_OK) {
-        _PR_LOG("Unable to declare node liveliness token! Error:%d\n", res);
-        return PICOROS_ERROR;
+static void intra_read_end(intra_topic_t* t) {
+    __atomic_fetch_sub(&t->readers, 1, __ATOMIC_SEQ_CST);
+    t_intra_readers[t - s_intra]--;
+}
+
+// Wait until deliveries of other threads can't reach an entity unlinked from registry topic.
+// Deliveries of calling thread, e.g. callback removing its own subscriber, are not waited for.
+static void intra_wait_readers(intra_topic_t* t) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&t->readers, __ATOMIC_SEQ_CST) > t_intra_readers[t - s_intra]) {
+        z_sleep_us(10);
     }
-    return PICOROS_OK;
 }
 
-void zenoh_shutdown() {
-    z_session_drop(z_session_move(&s_wrapper));
+// Wait for readers of topic after unlinking an entity, then try to free topic
+static void intra_unlinked(intra_topic_t* t) {
+    intra_wait_readers(t);
+    intra_lock();
+    intra_topic_release(t);
+    intra_unlock();
 }
 
-picoros_res_t picoros_publisher_declare(picoros_node_t* node, picoros_publisher_t* pub) {
-    z_view_keyexpr_t ke;
-    z_result_t res = Z_OK;
-    z_publisher_options_t *options = &pub->opts;
-    char keyexpr[KEYEXPR_SIZE];
-    if (pub->topic.type != NULL) {
-        rmw_zenoh_topic_keyexpr(node, &pub->topic, keyexpr);
-        z_view_keyexpr_from_str_unchecked(&ke, keyexpr);
+static picoros_res_t intra_add_pub(picoros_publisher_t* pub, const char* keyexpr) {
+    intra_lock();
+    intra_topic_t* t = intra_topic(keyexpr);
+    if (t != NULL) {
+        pub->_intra = t;
+        pub->_intra_next = t->pubs;
+        __atomic_store_n(&t->pubs, pub, __ATOMIC_RELEASE);
     }
-    else {
-        z_view_keyexpr_from_str_unchecked(&ke, pub->topic.name);
+    intra_unlock();
+    return (t != NULL) ? PICOROS_OK : PICOROS_ERROR;
+}
+
+static picoros_res_t intra_add_sub(picoros_subscriber_t* sub, const char* keyexpr) {
+    intra_lock();
+    intra_topic_t* t = intra_topic(keyexpr);
+    if (t != NULL) {
+        sub->_intra = t;
+        sub->_intra_next = t->subs;
+        __atomic_store_n(&t->subs, sub, __ATOMIC_RELEASE);
     }
+    intra_unlock();
+    return (t != NULL) ? PICOROS_OK : PICOROS_ERROR;
+}
 
-    rmw_zenoh_gen_attachment_gid(&pub->attachment);
+// Unlink publisher and wait until no subscriber reads it
+static void intra_remove_pub(picoros_publisher_t* pub) {
+    intra_topic_t* t = pub->_intra;
+    intra_lock();
+    picoros_publisher_t** link = &t->pubs;
+    while (*link != NULL && *link != pub) {
+        link = &(*link)->_intra_next;
+    }
+    if (*link == pub) {
+        __atomic_store_n(link, pub->_intra_next, __ATOMIC_RELEASE);
+    }
+    intra_unlock();
+    intra_unlinked(t);
+    pub->_intra = NULL;
+}
 
-    if ((res = z_declare_publisher(z_session_loan(&s_wrapper), &pub->zpub, z_view_keyexpr_loan(&ke), options)) != Z_OK) {
-        _PR_LOG("Unable to declare node liveliness token! Error:%d\n", res);
-        return PICOROS_ERROR;
+// Unlink subscriber and wait until no delivery can still reach it
+static void intra_remove_sub(picoros_subscriber_t* sub) {
+    intra_topic_t* t = sub->_intra;
+    intra_lock();
+    picoros_subscriber_t** link = &t->subs;
+    while (*link != NULL && *link != sub) {
+        link = &(*link)->_intra_next;
     }
+    if (*link == sub) {
+        __atomic_store_n(link, sub->_intra_next, __ATOMIC_RELEASE);
+    }
+    intra_unlock();
+    intra_unlinked(t);
+    sub->_intra = NULL;
+}
 
-    if (pub->topic.type != NULL) {
-        z_view_keyexpr_t ke2;
-        rmw_zenoh_topic_liveliness_keyexpr(node, &pub->topic, keyexpr, "MP");
-        z_view_keyexpr_from_str(&ke2, keyexpr);
+// Check if any local subscriber listens on publisher topic
+static bool intra_has_subs(picoros_publisher_t* pub) {
+    return pub->_intra != NULL && __atomic_load_n(&pub->_intra->subs, __ATOMIC_ACQUIRE) != NULL;
+}
 
-        z_owned_liveliness_token_t token;
-        if ((res = z_liveliness_declare_token(z_session_loan(&s_wrapper), &token, z_view_keyexpr_loan(&ke2), NULL)) != Z_OK) {
-            _PR_LOG("Unable to declare publisher liveliness token! Error:%d\n", res);
-            return PICOROS_ERROR;
-        }
+// Check if sample came from a local publisher, it was delivered already
+static bool intra_is_local(picoros_subscriber_t* sub, const picoros_sample_info_t* info) {
+    if (info == NULL) {
+        return false;
     }
-    return PICOROS_OK;
+    intra_topic_t* t = sub->_intra;
+    bool local = false;
+    intra_read_begin(t);
+    picoros_publisher_t* pub = __atomic_load_n(&t->pubs, __ATOMIC_ACQUIRE);
+    for (; pub != NULL && !local; pub = pub->_intra_next) {
+        local = memcmp(pub->attachment.rmw_gid, info->publisher_gid, RMW_GID_SIZE) == 0;
+    }
+    intra_read_end(t);
+    return local;
 }
 
-// Publish to a topic
-picoros_res_t picoros_publish(picoros_publisher_t* pub, uint8_t* payload, size_t len) {
+// Deliver payload to local subscribers, skip_msg skips those already given message struct
+static void intra_deliver(picoros_publisher_t* pub, const z_loaned_bytes_t* b, uint8_t* data, size_t len,
+                          bool skip_msg) {
+    intra_topic_t* t = pub->_intra;
+    picoros_sample_info_t info = {
+        .sequence_number = pub->attachment.sequence_number,
+        .source_timestamp = pub->attachment.time,
+    };
+    memcpy(info.publisher_gid, pub->attachment.rmw_gid, RMW_GID_SIZE);
+    intra_read_begin(t);
+    for (picoros_subscriber_t* sub = __atomic_load_n(&t->subs, __ATOMIC_ACQUIRE); sub != NULL; sub = sub->_intra_next) {
+        if (skip_msg && sub->msg_callback != NULL) {
+            continue;
+        }
+        if (sub_accept(sub, b, data, len, &info)) {
+            sub_deliver(sub, b, data, len, &info);
+        }
+    }
+    intra_read_end(t);
+}
+
+// Give message struct to local subscribers with msg_callback, returns true if any needs payload
+static bool intra_deliver_msg(picoros_publisher_t* pub, const void* msg) {
+    intra_topic_t* t = pub->_intra;
+    bool need_payload = false;
+    intra_read_begin(t);
+    for (picoros_subscriber_t* sub = __atomic_load_n(&t->subs, __ATOMIC_ACQUIRE); sub != NULL; sub = sub->_intra_next) {
+        if (sub->msg_callback == NULL) {
+            need_payload = true;
+        }
+        else if (sub->throttle == NULL || !throttle_drop(sub->throttle)) {
+            stats_message(sub->stats, 0);
+            STATS_CALLBACK(sub->stats, sub->msg_callback(sub, msg));
+        }
+        else {
+            stats_drop(sub->stats);
+        }
+    }
+    intra_read_end(t);
+    return need_payload;
+}
+
+// Parse rmw topic key expression <domain>/<name>/<type>_/RIHS01_<hash> in place
+static void topic_parse(picoros_topic_entry_t* entry, char* str) {
+    entry->domain_id = 0;
+    entry->topic.name = str;
+    entry->topic.type = NULL;
+    entry->topic.rihs_hash = NULL;
+
+    char* hash = strstr(str, "_/RIHS01_");
+    char* name = strchr(str, '/');
+    if (hash == NULL || name == NULL || name > hash) {
+        return;
+    }
+    char* type = hash;
+    while (type > name && *(type - 1) != '/') {
+        type--;
+    }
+    if (type == name + 1) {
+        return;
+    }
+    for (char* c = str; c < name && *c >= '0' && *c <= '9'; c++) {
+        entry->domain_id = entry->domain_id * 10u + (uint32_t)(*c - '0');
+    }
+    *name = 0;
+    *(type - 1) = 0;
+    *hash = 0;
+    entry->topic.name = name + 1;
+    entry->topic.type = type;
+    entry->topic.rihs_hash = hash + sizeof("_/RIHS01_") - 1;
+}
+
+// Find or add topic map entry of key expression, NULL if map is full
+static picoros_topic_entry_t* topic_lookup(picoros_subscriber_t* sub, const char* keyexpr, size_t len, uint32_t hash) {
+    picoros_topic_map_t* map = sub->topic_map;
+    uint16_t mask = map->size - 1;
+    uint16_t i = hash & mask;
+    // linear probing, entries are never removed so first free entry ends search
+    for (; map->entries[i].keyexpr != NULL; i = (i + 1) & mask) {
+        picoros_topic_entry_t* entry = &map->entries[i];
+        if (entry->_hash == hash && entry->keyexpr_len == len && memcmp(entry->keyexpr, keyexpr, len) == 0) {
+            return entry;
+        }
+    }
+    if (map->_count >= map->size - map->size / 4) {
+        return NULL;
+    }
+
+    // key expression and parsed copy in one allocation
+    char* mem = (char*)z_malloc(2 * (len + 1));
+    if (mem == NULL) {
+        return NULL;
+    }
+    picoros_topic_entry_t* entry = &map->entries[i];
+    memcpy(mem, keyexpr, len);
+    mem[len] = 0;
+    memcpy(mem + len + 1, keyexpr, len + 1);
+    topic_parse(entry, mem + len + 1);
+    entry->keyexpr_len = len;
+    entry->_hash = hash;
+    entry->keyexpr = mem;
+    map->_count++;
+    if (map->new_topic_callback != NULL) {
+        map->new_topic_callback(sub, entry);
+    }
+    return entry;
+}
+
+// Route wildcard subscription sample to handler of its topic
+static void topic_deliver(picoros_subscriber_t* sub, const z_loaned_sample_t* sample, const z_loaned_bytes_t* b,
+                          uint8_t* data, size_t len, const picoros_sample_info_t* info) {
+    z_view_string_t ke;
+    z_keyexpr_as_view_string(z_sample_keyexpr(sample), &ke);
+    const char* keyexpr = z_string_data(z_view_string_loan(&ke));
+    size_t keyexpr_len = z_string_len(z_view_string_loan(&ke));
+
+    picoros_rx_view_t view;
+    rx_view_init(&view, b, data, len, info);
+
+    picoros_topic_entry_t* entry = topic_lookup(sub, keyexpr, keyexpr_len, keyexpr_hash(keyexpr, keyexpr_len));
+    if (entry == NULL) {
+        // not cached, parse for this sample only
+        sub->topic_map->overflow++;
+        if (keyexpr_len >= KEYEXPR_SIZE || sub->topic_callback == NULL) {
+            return;
+        }
+        char str[2 * KEYEXPR_SIZE];
+        memcpy(str, keyexpr, keyexpr_len);
+        str[keyexpr_len] = 0;
+        memcpy(str + keyexpr_len + 1, str, keyexpr_len + 1);
+        picoros_topic_entry_t tmp = {
+            .keyexpr = str,
+            .keyexpr_len = keyexpr_len,
+            .samples = 1,
+        };
+        topic_parse(&tmp, str + keyexpr_len + 1);
+        STATS_CALLBACK(sub->stats, sub->topic_callback(sub, &tmp, &view));
+        return;
+    }
+    entry->samples++;
+    if (entry->handler != NULL) {
+        STATS_CALLBACK(sub->stats, entry->handler(sub, entry, &view));
+    }
+    else if (sub->topic_callback != NULL) {
+        STATS_CALLBACK(sub->stats, sub->topic_callback(sub, entry, &view));
+    }
+}
+
+// Deliver accepted sample to subscriber or its topic handler
+static void sub_receive(picoros_subscriber_t* sub, const z_loaned_sample_t* sample, const z_loaned_bytes_t* b,
+                        uint8_t* data, size_t len, const picoros_sample_info_t* info) {
+    if (sub->topic_map != NULL) {
+        topic_deliver(sub, sample, b, data, len, info);
+    }
+    else {
+        sub_deliver(sub, b, data, len, info);
+    }
+}
+
+static void sub_data_handler(z_loaned_sample_t *sample, void *ctx) {
+    picoros_subscriber_t* sub = (picoros_subscriber_t*)ctx;
+    picoros_sample_info_t info_buf;
+    const picoros_sample_info_t* info = sample_info_parse(sample, &info_buf);
+    if (sub->_intra != NULL && intra_is_local(sub, info)) {
+        return;
+    }
+    const z_loaned_bytes_t *b = z_sample_payload(sample);
+
+    size_t raw_data_len = _z_bytes_len(b);
+    PICOTRACE_BEGIN(PICOTRACE_EV_SAMPLE, raw_data_len);
+    if (raw_data_len != 0 && sub_accept(sub, b, NULL, raw_data_len, info)) {
+        sub_receive(sub, sample, b, NULL, raw_data_len, info);
+    }
+    PICOTRACE_END(PICOTRACE_EV_SAMPLE, raw_data_len);
+}
+
+// Fan out sample of shared zenoh subscriber, user callbacks share one receive buffer
+static void shared_data_handler(z_loaned_sample_t *sample, void *ctx) {
+    intra_topic_t* t = (intra_topic_t*)ctx;
+    const z_loaned_bytes_t *b = z_sample_payload(sample);
+    size_t raw_data_len = _z_bytes_len(b);
+    if (raw_data_len == 0) {
+        return;
+    }
+    PICOTRACE_BEGIN(PICOTRACE_EV_SAMPLE, raw_data_len);
+    picoros_sample_info_t info_buf;
+    const picoros_sample_info_t* info = sample_info_parse(sample, &info_buf);
+
+    uint8_t* raw_data = NULL;
+    picoros_pool_t* pool = NULL;
+    intra_read_begin(t);
+    for (picoros_subscriber_t* sub = __atomic_load_n(&t->shared, __ATOMIC_ACQUIRE); sub != NULL; sub = sub->_shared_next) {
+        if (sub->_intra != NULL && intra_is_local(sub, info)) {
+            continue;
+        }
+        if (!sub_accept(sub, b, raw_data, raw_data_len, info)) {
+            continue;
+        }
+        bool copy = sub->mailbox == NULL && sub->executor == NULL && sub->view_callback == NULL
+                    && sub->topic_map == NULL;
+        if (copy && raw_data == NULL && sub->user_callback != NULL) {
+            pool = sub->rx_pool;
+            if ((raw_data = pool_get(pool, raw_data_len, sub->stats)) != NULL) {
+                _z_bytes_to_buf(b, raw_data, raw_data_len);
+            }
+        }
+        sub_receive(sub, sample, b, raw_data, raw_data_len, info);
+    }
+    intra_read_end(t);
+    if (raw_data != NULL) {
+        pool_put(pool, raw_data);
+    }
+    PICOTRACE_END(PICOTRACE_EV_SAMPLE, raw_data_len);
+}
+
+// Add subscriber to shared zenoh subscriber of its key expression and session, first one declares it
+// together with liveliness token on lv_ke, if given. Subscriber gets own zenoh subscriber and token if
+// registry is full, topic is shared on another session or its zenoh subscriber is being declared or undeclared.
+static picoros_res_t shared_join(picoros_node_t* node, picoros_subscriber_t* sub, const char* keyexpr,
+                                 const z_loaned_keyexpr_t* ke, const z_loaned_keyexpr_t* lv_ke) {
+    picoros_session_t* session = SESSION(node->session);
+    intra_lock();
+    intra_topic_t* t = intra_topic(keyexpr);
+    if (t != NULL && t->shared != NULL && t->session == session) {
+        sub->_shared = t;
+        sub->_shared_next = t->shared;
+        __atomic_store_n(&t->shared, sub, __ATOMIC_RELEASE);
+        intra_unlock();
+        return PICOROS_OK;
+    }
+    bool own = (t == NULL || t->shared != NULL || t->zsub_busy);
+    if (!own) {
+        t->zsub_busy = true;
+        t->session = session;
+    }
+    intra_unlock();
+
+    // declare outside registry lock, zenoh may run callbacks of other subscribers meanwhile
+    z_result_t res;
+    z_owned_closure_sample_t callback;
+    if (own) {
+        z_closure_sample(&callback, sub_data_handler, NULL, sub);
+        res = z_declare_subscriber(z_session_loan(&session->zsession), &sub->zsub, ke, z_closure_sample_move(&callback), NULL);
+    }
+    else {
+        z_closure_sample(&callback, shared_data_handler, NULL, t);
+        res = z_declare_subscriber(z_session_loan(&session->zsession), &t->zsub, ke, z_closure_sample_move(&callback), NULL);
+    }
+    if (res == Z_OK && lv_ke != NULL) {
+        z_owned_liveliness_token_t* token = own ? &sub->_token : &t->token;
+        if ((res = z_liveliness_declare_token(z_session_loan(&session->zsession), token, lv_ke, NULL)) != Z_OK) {
+            _PR_LOG("Unable to declare subscriber liveliness token! Error:%d\n", res);
+            z_undeclare_subscriber(z_subscriber_move(own ? &sub->zsub : &t->zsub));
+        }
+    }
+    if (t != NULL) {
+        intra_lock();
+        if (!own) {
+            t->zsub_busy = false;
+            t->has_token = (res == Z_OK && lv_ke != NULL);
+            if (res == Z_OK) {
+                sub->_shared = t;
+                sub->_shared_next = NULL;
+                __atomic_store_n(&t->shared, sub, __ATOMIC_RELEASE);
+            }
+        }
+        intra_topic_release(t);
+        intra_unlock();
+    }
+    if (res != Z_OK) {
+        _PR_LOG("Unable to declare subscriber! Error:%d\n", res);
+        return PICOROS_ERROR;
+    }
+    return PICOROS_OK;
+}
+
+// Remove subscriber from shared zenoh subscriber, last one undeclares it
+static picoros_res_t shared_leave(picoros_subscriber_t* sub) {
+    intra_topic_t* t = sub->_shared;
+    z_result_t res = Z_OK;
+    intra_lock();
+    picoros_subscriber_t** link = &t->shared;
+    while (*link != NULL && *link != sub) {
+        link = &(*link)->_shared_next;
+    }
+    if (*link == sub) {
+        __atomic_store_n(link, sub->_shared_next, __ATOMIC_RELEASE);
+    }
+    bool last = (t->shared == NULL);
+    if (last) {
+        t->zsub_busy = true;
+    }
+    intra_unlock();
+
+    if (last) {
+        if (t->has_token) {
+            z_liveliness_undeclare_token(z_liveliness_token_move(&t->token));
+            t->has_token = false;
+        }
+        res = z_undeclare_subscriber(z_subscriber_move(&t->zsub));
+    }
+    intra_wait_readers(t);
+    intra_lock();
+    if (last) {
+        t->zsub_busy = false;
+    }
+    intra_topic_release(t);
+    intra_unlock();
+    sub->_shared = NULL;
+    return (res == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+}
+
+// Reply attachment, echoes request sequence number and client GID so client can match the reply
+static void srv_reply_attachment(picoros_srv_server_t* srv, const z_loaned_query_t* query, rmw_attachment_t* attachment) {
+    *attachment = srv->attachment;
+    const z_loaned_bytes_t* rx_attachment = z_query_attachment(query);
+    if (rx_attachment != NULL && _z_bytes_len(rx_attachment) == sizeof(rmw_attachment_t)) {
+        _z_bytes_to_buf(rx_attachment, (uint8_t*)attachment, sizeof(rmw_attachment_t));
+    }
+    else {
+        attachment->sequence_number = 1;
+    }
+}
+
+// Send service reply with rmw attachment
+static z_result_t srv_send_reply(const z_loaned_query_t* query, rmw_attachment_t* attachment, uint8_t* data, size_t len) {
+    // reply is sent before returning, zbytes can alias reply data
+    z_owned_bytes_t reply_payload;
+    z_bytes_from_static_buf(&reply_payload, data, len);
+
+    attachment->time = rmw_zenoh_time_ns();
+    z_query_reply_options_t options;
+    z_query_reply_options_default(&options);
+    z_owned_bytes_t tx_attachment;
+    z_bytes_from_static_buf(&tx_attachment, (uint8_t*)attachment, sizeof(rmw_attachment_t));
+    options.attachment = z_bytes_move(&tx_attachment);
+
+    // send reply
+    z_result_t res = z_query_reply(query, z_query_keyexpr(query), z_bytes_move(&reply_payload), &options);
+    if (res != Z_OK) {
+        _PR_LOG("Error sending service reply. Error:%d\n", res);
+    }
+    z_bytes_drop(z_bytes_move(&reply_payload));
+    return res;
+}
+
+// Reject request with error reply
+static void srv_reject(picoros_srv_server_t* srv, const z_loaned_query_t* query) {
+    static const char busy[] = "service busy";
+    __atomic_fetch_add(&srv->rejected, 1, __ATOMIC_RELAXED);
+    z_owned_bytes_t payload;
+    z_bytes_from_static_buf(&payload, (const uint8_t*)busy, sizeof(busy) - 1);
+    z_query_reply_err_options_t options;
+    z_query_reply_err_options_default(&options);
+    z_query_reply_err(query, z_bytes_move(&payload), &options);
+}
+
+// Release deferred request handle
+static void srv_request_release(picoros_srv_request_t* req) {
+    picoros_srv_server_t* srv = req->server;
+    pool_put(srv->rx_pool, req->data);
+    req->data = NULL;
+    mask_release(&srv->_pending, (uint32_t)(req - srv->requests));
+}
+
+// Queue request to worker pool, returns false if pool is not running
+static bool workers_push(picoros_workers_t* workers, picoros_srv_request_t* req) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    bool ok = false;
+    z_mutex_lock(z_mutex_loan_mut(&workers->_mutex));
+    if (workers->_running) {
+        req->_next = NULL;
+        if (workers->_tail != NULL) {
+            workers->_tail->_next = req;
+        }
+        else {
+            workers->_head = req;
+        }
+        workers->_tail = req;
+        z_condvar_signal(z_condvar_loan_mut(&workers->_cond));
+        ok = true;
+    }
+    z_mutex_unlock(z_mutex_loan_mut(&workers->_mutex));
+    return ok;
+#else
+    return false;
+#endif
+}
+
+#if Z_FEATURE_MULTI_THREAD == 1
+// Worker thread, processes queued deferred requests until pool is stopped and queue is empty
+static void* worker_task(void* arg) {
+    picoros_workers_t* workers = (picoros_workers_t*)arg;
+    for (;;) {
+        z_mutex_lock(z_mutex_loan_mut(&workers->_mutex));
+        while (workers->_head == NULL && workers->_running) {
+            z_condvar_wait(z_condvar_loan_mut(&workers->_cond), z_mutex_loan_mut(&workers->_mutex));
+        }
+        picoros_srv_request_t* req = workers->_head;
+        if (req != NULL) {
+            workers->_head = req->_next;
+            if (workers->_head == NULL) {
+                workers->_tail = NULL;
+            }
+        }
+        z_mutex_unlock(z_mutex_loan_mut(&workers->_mutex));
+        if (req == NULL) {
+            return NULL;
+        }
+        STATS_CALLBACK(req->server->stats, req->server->deferred_callback(req->server, req));
+    }
+}
+#endif
+
+// Take deferred request handle and hand request to worker pool or callback
+static void srv_defer(picoros_srv_server_t* srv, z_loaned_query_t* query) {
+    uint8_t max_pending = (srv->max_pending < PICOROS_SRV_MAX_PENDING) ? srv->max_pending : PICOROS_SRV_MAX_PENDING;
+    int idx = (srv->requests != NULL) ? mask_claim(&srv->_pending, max_pending) : -1;
+    if (idx < 0) {
+        _PR_LOG("Service request rejected, too many pending\n");
+        stats_drop(srv->stats);
+        srv_reject(srv, query);
+        return;
+    }
+    picoros_srv_request_t* req = &srv->requests[idx];
+    req->server = srv;
+
+    // get request data
+    const z_loaned_bytes_t *b = z_query_payload(query);
+    req->len = _z_bytes_len(b);
+    req->data = pool_get(srv->rx_pool, req->len, srv->stats);
+    if (req->data == NULL && req->len != 0) {
+        _PR_LOG("Service request rejected, no receive buffer\n");
+        srv_request_release(req);
+        srv_reject(srv, query);
+        return;
+    }
+    _z_bytes_to_buf(b, req->data, req->len);
+    srv_reply_attachment(srv, query, &req->_attachment);
+
+    // keep query alive until reply
+    if (z_query_clone(&req->_query, query) != Z_OK) {
+        _PR_LOG("Service request dropped, query clone failed\n");
+        stats_drop(srv->stats);
+        srv_request_release(req);
+        return;
+    }
+    stats_message(srv->stats, req->len);
+    if (srv->workers == NULL || !workers_push(srv->workers, req)) {
+        STATS_CALLBACK(srv->stats, srv->deferred_callback(srv, req));
+    }
+}
+
+// Handle service request on read task
+static void srv_handle_query(picoros_srv_server_t* srv, z_loaned_query_t *query) {
+    if (srv->deferred_callback != NULL){
+        srv_defer(srv, query);
+        return;
+    }
+    if (srv->user_callback == NULL){
+        return;
+    }
+
+    const z_loaned_bytes_t *b = z_query_payload(query);
+    size_t rx_data_len = _z_bytes_len(b);
+
+    // get request data
+    uint8_t* rx_data = pool_get(srv->rx_pool, rx_data_len, srv->stats);
+    if (rx_data == NULL) {
+        _PR_LOG("Service request dropped, no receive buffer\n");
+        return;
+    }
+    _z_bytes_to_buf(b, rx_data, rx_data_len);
+    stats_message(srv->stats, rx_data_len);
+
+    // process
+    picoros_service_reply_t reply;
+    STATS_CALLBACK(srv->stats, reply = srv->user_callback(srv, rx_data, rx_data_len));
+
+    if (reply.data) {
+        rmw_attachment_t attachment;
+        srv_reply_attachment(srv, query, &attachment);
+        srv_send_reply(query, &attachment, reply.data, reply.length);
+
+        // cleanup
+        if (reply.free_callback != NULL) {
+            reply.free_callback(reply.data);
+        }
+    }
+    pool_put(srv->rx_pool, rx_data);
+}
+
+static void queriable_data_handler(z_loaned_query_t *query, void *arg) {
+    PICOTRACE_BEGIN(PICOTRACE_EV_SRV_REQUEST, 0);
+    srv_handle_query((picoros_srv_server_t*)arg, query);
+    PICOTRACE_END(PICOTRACE_EV_SRV_REQUEST, 0);
+}
+
+static void queriable_drop_handler(void* arg) { _PR_LOG("Drop srv callback\n"); }
+
+// Free slot unless it was already freed and reused
+static void slot_release(picoros_srv_slot_t* slot, int64_t seq) {
+    __atomic_compare_exchange_n(&slot->sequence_number, &seq, 0, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+// Complete synchronous call waiting on a slot, payload is NULL when request is dropped.
+// Call is ignored if slot was freed by a timeout, seq is request of the reply. Slot is freed for
+// next call at once, pending drop of the query keeps only its query context.
+static void sync_complete(picoros_srv_slot_t* slot, int64_t seq, const z_loaned_bytes_t* payload, bool error) {
+    picoros_srv_client_t* client = slot->client;
+    SYNC_LOCK(client);
+    sync_call_t* sync = (sync_call_t*)slot->sync;
+    if (sync != NULL && __atomic_load_n(&slot->sequence_number, __ATOMIC_ACQUIRE) == seq) {
+        if (payload != NULL) {
+            sync->len = _z_bytes_len(payload);
+            if (sync->len <= sync->size) {
+                _z_bytes_to_buf(payload, sync->buf, sync->len);
+            }
+            sync->replied = true;
+            sync->error = error;
+        }
+        sync->done = true;
+        slot->sync = NULL;
+        slot_release(slot, seq);
+#if Z_FEATURE_MULTI_THREAD == 1
+        z_condvar_signal_all(z_condvar_loan_mut(&client->_cond));
+#endif
+    }
+    SYNC_UNLOCK(client);
+}
+
+
+// Claim free query context of a slot for request seq, NULL if all queries are pending
+static picoros_srv_query_t* slot_query_claim(picoros_srv_slot_t* slot, int64_t seq) {
+    for (uint8_t i = 0; i < PICOROS_SRV_SLOT_QUERIES; i++) {
+        picoros_srv_query_t* query = &slot->_queries[i];
+        int64_t free_seq = 0;
+        if (__atomic_compare_exchange_n(&query->sequence_number, &free_seq, seq, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            query->slot = slot;
+            return query;
+        }
+    }
+    return NULL;
+}
+
+static void get_drop_handler(void* ctx){
+    picoros_srv_query_t* query = (picoros_srv_query_t*)ctx;
+    picoros_srv_slot_t* slot = query->slot;
+    picoros_srv_client_t* client = slot->client;
+    int64_t seq = query->sequence_number;
+    bool is_sync = query->is_sync;
+    __atomic_store_n(&query->sequence_number, 0, __ATOMIC_RELEASE);
+    if (is_sync) {
+        sync_complete(slot, seq, NULL, false);
+        slot_release(slot, seq);
+        return;
+    }
+    // free slot first so drop callback can start a new request
+    slot_release(slot, seq);
+    if(client->drop_callback != NULL){
+        client->reply_seq = seq;
+        client->drop_callback(client);
+    }
+}
+
+// Handle service reply on read task
+static void client_handle_reply(picoros_srv_query_t* query, z_loaned_reply_t *reply){
+    size_t raw_data_len = 0;
+    uint8_t* raw_data  = 0;
+    bool error = false;
+    const z_loaned_sample_t* sample = 0;
+    const z_loaned_bytes_t* payload = 0;
+    const z_loaned_reply_err_t* err = 0;
+
+    if (z_reply_is_ok(reply)) {
+        sample = z_reply_ok(reply);
+        payload = z_sample_payload(sample);
+    }
+    else {
+        err = z_reply_err(reply);
+        payload = z_reply_err_payload(err);
+        error = true;
+    }
+
+    if (query->is_sync) {
+        sync_complete(query->slot, query->sequence_number, payload, error);
+        return;
+    }
+
+    raw_data_len = _z_bytes_len(payload);
+    if (raw_data_len == 0) {
+        return;
+    }
+    picoros_srv_client_t* client = query->slot->client;
+    raw_data = pool_get(client->rx_pool, raw_data_len, NULL);
+    if (raw_data == NULL) {
+        return;
+    }
+    _z_bytes_to_buf(payload, raw_data, raw_data_len);
+
+    client->reply_seq = query->sequence_number;
+    client->user_callback(client, raw_data, raw_data_len, error);
+    pool_put(client->rx_pool, raw_data);
+}
+
+static void get_data_handler(z_loaned_reply_t *reply, void *ctx){
+    picoros_srv_query_t* query = (picoros_srv_query_t*)ctx;
+    // late reply of timed out synchronous call, slot may serve another request
+    if (query == NULL || __atomic_load_n(&query->slot->sequence_number, __ATOMIC_ACQUIRE) != query->sequence_number){
+        return;
+    }
+    PICOTRACE_BEGIN(PICOTRACE_EV_SRV_REPLY, 0);
+    client_handle_reply(query, reply);
+    PICOTRACE_END(PICOTRACE_EV_SRV_REPLY, 0);
+}
+
+#if Z_FEATURE_BATCHING == 1
+// Send pending automatic batch
+static void batch_send(picoros_session_t* session) {
+    __atomic_store_n(&session->_batch.pending, 0, __ATOMIC_RELAXED);
+    zp_batch_flush(z_session_loan(&session->zsession));
+}
+
+// Time until latency limit of pending batch is reached
+static uint64_t batch_deadline_us(picoros_batch_state_t* batch) {
+    if (batch->cfg.max_latency_us == 0 || __atomic_load_n(&batch->pending, __ATOMIC_RELAXED) == 0) {
+        return UINT64_MAX;
+    }
+    uint64_t age = z_clock_elapsed_us(&batch->epoch) - __atomic_load_n(&batch->first_us, __ATOMIC_RELAXED);
+    return (age >= batch->cfg.max_latency_us) ? 0 : batch->cfg.max_latency_us - age;
+}
+
+// Wake latency flush task waiting for first publication of a batch
+static void batch_wake(picoros_batch_state_t* batch) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (__atomic_load_n(&batch->idle, __ATOMIC_SEQ_CST)) {
+        z_mutex_lock(z_mutex_loan_mut(&batch->mutex));
+        z_condvar_signal(z_condvar_loan_mut(&batch->cond));
+        z_mutex_unlock(z_mutex_loan_mut(&batch->mutex));
+    }
+#else
+    (void)batch;
+#endif
+}
+
+// Account published bytes and flush automatic batch when a limit is reached
+static void batch_account(picoros_session_t* session, size_t len) {
+    picoros_batch_state_t* batch = &session->_batch;
+    if (!__atomic_load_n(&batch->automatic, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    if (__atomic_fetch_add(&batch->pending, len, __ATOMIC_SEQ_CST) == 0) {
+        __atomic_store_n(&batch->first_us, z_clock_elapsed_us(&batch->epoch), __ATOMIC_RELAXED);
+        batch_wake(batch);
+    }
+    if ((batch->cfg.max_bytes != 0 && __atomic_load_n(&batch->pending, __ATOMIC_RELAXED) >= batch->cfg.max_bytes)
+        || batch_deadline_us(batch) == 0) {
+        batch_send(session);
+    }
+}
+
+// Stop automatic batching of a session
+static void batch_stop(picoros_session_t* session) {
+    picoros_batch_state_t* batch = &session->_batch;
+    if (!__atomic_exchange_n(&batch->automatic, false, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (batch->cfg.max_latency_us != 0) {
+        z_mutex_lock(z_mutex_loan_mut(&batch->mutex));
+        z_condvar_signal(z_condvar_loan_mut(&batch->cond));
+        z_mutex_unlock(z_mutex_loan_mut(&batch->mutex));
+        z_task_join(z_task_move(&batch->task));
+        z_condvar_drop(z_condvar_move(&batch->cond));
+        z_mutex_drop(z_mutex_move(&batch->mutex));
+    }
+#endif
+    zp_batch_stop(z_session_loan(&session->zsession));
+}
+
+#if Z_FEATURE_MULTI_THREAD == 1
+// Flushes automatic batch of a session when latency limit is reached,
+// sleeps on condition variable while nothing is pending
+static void* batch_task(void* arg) {
+    picoros_session_t* session = (picoros_session_t*)arg;
+    picoros_batch_state_t* batch = &session->_batch;
+    while (__atomic_load_n(&batch->automatic, __ATOMIC_ACQUIRE)) {
+        uint64_t sleep_us = batch_deadline_us(batch);
+        if (sleep_us == 0) {
+            batch_send(session);
+        }
+        else if (sleep_us != UINT64_MAX) {
+            z_sleep_us(sleep_us);
+        }
+        else {
+            // publisher sees this task idle after making batch pending and signals
+            z_mutex_lock(z_mutex_loan_mut(&batch->mutex));
+            __atomic_store_n(&batch->idle, true, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&batch->automatic, __ATOMIC_ACQUIRE)
+                   && __atomic_load_n(&batch->pending, __ATOMIC_SEQ_CST) == 0) {
+                z_condvar_wait(z_condvar_loan_mut(&batch->cond), z_mutex_loan_mut(&batch->mutex));
+            }
+            __atomic_store_n(&batch->idle, false, __ATOMIC_SEQ_CST);
+            z_mutex_unlock(z_mutex_loan_mut(&batch->mutex));
+        }
+    }
+    return NULL;
+}
+#endif
+#else
+#define batch_account(session, len)
+#define batch_stop(session)
+#endif
+
+// Open zenoh session and start its read and lease tasks
+static picoros_res_t session_open(picoros_session_t* session, picoros_interface_t* ifx, zp_task_read_options_t* read_opts) {
+    z_result_t res = Z_OK;
+    z_owned_config_t config;
+    z_config_default(&config);
+
+    _PR_LOG("Configuring Zenoh session...\r\n");
+    zp_config_insert(z_config_loan_mut(&config), Z_CONFIG_MODE_KEY, ifx->mode);
+    if (ifx->locator) {
+        if (strcmp(ifx->mode, "client") == 0) {
+            zp_config_insert(z_config_loan_mut(&config), Z_CONFIG_CONNECT_KEY, ifx->locator);
+        }
+        else {
+            zp_config_insert(z_config_loan_mut(&config), Z_CONFIG_LISTEN_KEY, ifx->locator);
+        }
+    }
+
+    _PR_LOG("Opening Zenoh session...\r\n");
+    if ((res = z_open(&session->zsession, z_config_move(&config), NULL)) != Z_OK) {
+        _PR_LOG("Unable to open Zenoh session! Error:%d\n", res);
+        return PICOROS_NOT_READY;
+    }
+    _PR_LOG("Zenoh setup finished!\r\n");
+
+    // Start read and lease tasks for zenoh-pico
+    if((res = zp_start_read_task(z_session_loan_mut(&session->zsession), read_opts)) != Z_OK
+    || (res = zp_start_lease_task(z_session_loan_mut(&session->zsession), NULL)) != Z_OK
+    ){
+        z_session_drop(z_session_move(&session->zsession));
+        _PR_LOG("Failed to start read/lease tasks! Error:%d\n", res);
+        return PICOROS_ERROR;
+    }
+    return PICOROS_OK;
+}
+
+// Stop session tasks and close it
+static void session_close(picoros_session_t* session) {
+    batch_stop(session);
+    zp_stop_read_task(z_session_loan_mut(&session->zsession));
+    zp_stop_lease_task(z_session_loan_mut(&session->zsession));
+    z_session_drop(z_session_move(&session->zsession));
+}
+
+// Size of cache record with header, records are 8 byte aligned
+static size_t cache_record_size(size_t len) {
+    return (sizeof(cache_record_t) + len + 7u) & ~(size_t)7u;
+}
+
+// Drop oldest cached publication
+static void cache_evict(picoros_pub_cache_t* cache) {
+    cache_record_t rec;
+    memcpy(&rec, cache->mem + cache->_first, sizeof(rec));
+    cache->_first += cache_record_size(rec.len);
+    if (--cache->_count == 0) {
+        cache->_first = 0;
+        cache->_next = 0;
+        cache->_wrap = 0;
+    }
+    else if (cache->_wrap != 0 && cache->_first >= cache->_wrap) {
+        cache->_first = 0;
+        cache->_wrap = 0;
+    }
+}
+
+// Store publication with its attachment, oldest are evicted for depth and memory budget
+static void cache_put(picoros_publisher_t* pub, const uint8_t* data, size_t len) {
+    picoros_pub_cache_t* cache = pub->cache;
+    size_t size = cache_record_size(len);
+    if (size > cache->size) {
+        cache->oversize++;
+        return;
+    }
+    uint32_t depth = (pub->qos.depth != 0) ? pub->qos.depth : 1;
+
+    CACHE_LOCK(cache);
+    while (cache->_count >= depth) {
+        cache_evict(cache);
+    }
+    for (;;) {
+        if (cache->_wrap == 0) {
+            if (cache->size - cache->_next >= size) {
+                break;
+            }
+            if (cache->_first >= size) {
+                cache->_wrap = cache->_next;
+                cache->_next = 0;
+                break;
+            }
+        }
+        else if (cache->_first - cache->_next >= size) {
+            break;
+        }
+        cache_evict(cache);
+        cache->evicted++;
+    }
+    cache_record_t rec = {
+        .len = len,
+        .attachment = pub->attachment,
+    };
+    memcpy(cache->mem + cache->_next, &rec, sizeof(rec));
+    memcpy(cache->mem + cache->_next + sizeof(rec), data, len);
+    cache->_next += size;
+    cache->_count++;
+    CACHE_UNLOCK(cache);
+}
+
+// Reply to query with cached publications, oldest first. Records are copied out first,
+// so publisher is not blocked while replies are sent
+static void cache_query_handler(z_loaned_query_t* query, void* ctx) {
+    picoros_publisher_t* pub = (picoros_publisher_t*)ctx;
+    picoros_pub_cache_t* cache = pub->cache;
+
+    CACHE_LOCK(cache);
+    uint32_t count = cache->_count;
+    size_t first_len = (cache->_wrap != 0) ? cache->_wrap - cache->_first : cache->_next - cache->_first;
+    size_t wrap_len = (cache->_wrap != 0) ? cache->_next : 0;
+    uint8_t* records = (count != 0) ? (uint8_t*)z_malloc(first_len + wrap_len) : NULL;
+    if (records != NULL) {
+        memcpy(records, cache->mem + cache->_first, first_len);
+        memcpy(records + first_len, cache->mem, wrap_len);
+    }
+    CACHE_UNLOCK(cache);
+    if (records == NULL) {
+        return;
+    }
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        cache_record_t rec;
+        memcpy(&rec, records + offset, sizeof(rec));
+
+        // reply is sent before returning, zbytes can alias copied records
+        z_owned_bytes_t payload;
+        z_bytes_from_static_buf(&payload, records + offset + sizeof(rec), rec.len);
+        z_owned_bytes_t attachment;
+        z_bytes_from_static_buf(&attachment, (uint8_t*)&rec.attachment, sizeof(rmw_attachment_t));
+        z_query_reply_options_t options;
+        z_query_reply_options_default(&options);
+        options.attachment = z_bytes_move(&attachment);
+        z_result_t res = z_query_reply(query, z_publisher_keyexpr(z_publisher_loan(&pub->zpub)), z_bytes_move(&payload), &options);
+        if (res != Z_OK) {
+            _PR_LOG("Error sending cached publication. Error:%d\n", res);
+            break;
+        }
+        offset += cache_record_size(rec.len);
+    }
+    z_free(records);
+}
+
+// Set up publication cache and its queryable on publisher key expression
+static picoros_res_t cache_declare(picoros_node_t* node, picoros_publisher_t* pub, const z_loaned_keyexpr_t* ke) {
+    picoros_pub_cache_t* cache = pub->cache;
+    if (cache == NULL || cache->size < cache_record_size(0)) {
+        _PR_LOG("Transient local publisher needs a cache\n");
+        return PICOROS_ERROR;
+    }
+    if (cache->mem == NULL && (cache->mem = (uint8_t*)z_malloc(cache->size)) == NULL) {
+        return PICOROS_ERROR;
+    }
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_mutex_init(&cache->_mutex);
+#endif
+    z_queryable_options_t options;
+    z_queryable_options_default(&options);
+    z_owned_closure_query_t callback;
+    z_closure_query(&callback, cache_query_handler, NULL, pub);
+    z_result_t res = z_declare_queryable(ZSESSION(node->session), &cache->_zqable, ke, z_closure_query_move(&callback), &options);
+    if (res != Z_OK) {
+        _PR_LOG("Unable to declare publication cache! Error:%d\n", res);
+        return PICOROS_ERROR;
+    }
+    return PICOROS_OK;
+}
+
+// Undeclare queryable of publication cache, cache memory stays with the user
+static void cache_undeclare(picoros_pub_cache_t* cache) {
+    z_undeclare_queryable(z_queryable_move(&cache->_zqable));
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_mutex_drop(z_mutex_move(&cache->_mutex));
+#endif
+}
+
+// Undeclare zenoh publisher and its publication cache
+static z_result_t publisher_release(picoros_publisher_t* pub) {
+    if (pub->qos.durability == PICOROS_DURABILITY_TRANSIENT_LOCAL) {
+        cache_undeclare(pub->cache);
+    }
+    return z_undeclare_publisher(z_publisher_move(&pub->zpub));
+}
+
+// Cached publication received by transient local subscriber
+static void cache_reply_handler(z_loaned_reply_t* reply, void* ctx) {
+    if (z_reply_is_ok(reply)) {
+        sub_data_handler((z_loaned_sample_t*)z_reply_ok(reply), ctx);
+    }
+}
+
+// Query cached publications of all publishers on subscriber key expression
+static picoros_res_t cache_query(picoros_node_t* node, picoros_subscriber_t* sub, const z_loaned_keyexpr_t* ke) {
+    z_get_options_t options;
+    z_get_options_default(&options);
+    options.target = Z_QUERY_TARGET_ALL;
+    options.consolidation = z_query_consolidation_none();
+
+    z_owned_closure_reply_t callback;
+    z_closure_reply(&callback, cache_reply_handler, NULL, sub);
+    z_result_t res = z_get(ZSESSION(node->session), ke, "", z_closure_reply_move(&callback), &options);
+    if (res != Z_OK) {
+        _PR_LOG("Unable to query publication caches! Error:%d\n", res);
+        return PICOROS_ERROR;
+    }
+    return PICOROS_OK;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+picoros_res_t picoros_pool_init(picoros_pool_t* pool) {
+    if (pool == NULL || pool->buf_count == 0 || pool->buf_count > PICOROS_POOL_MAX_BUFFERS || pool->buf_size == 0) {
+        return PICOROS_ERROR;
+    }
+    if (pool->mem == NULL) {
+        pool->mem = (uint8_t*)z_malloc(pool->buf_count * pool->buf_size);
+        if (pool->mem == NULL) {
+            return PICOROS_ERROR;
+        }
+    }
+    pool->_used = 0;
+    pool->dropped = 0;
+    pool->heap_fallbacks = 0;
+    return PICOROS_OK;
+}
+
+picoros_res_t picoros_interface_init(picoros_interface_t* ifx) {
+    zp_task_read_options_t read_opts;
+    zp_task_read_options_default(&read_opts);
+#if Z_FEATURE_MULTI_THREAD == 1
+    read_opts.task_attributes = ifx->read_task_attr;
+#endif
+    return session_open(SESSION(ifx->session), ifx, &read_opts);
+}
+
+void picoros_interface_shutdown(void) {
+    session_close(&s_default);
+}
+
+void zenoh_shutdown(void) {
+    picoros_interface_shutdown();
+}
+
+void picoros_session_shutdown(picoros_session_t* session) {
+    session_close(SESSION(session));
+}
+
+picoros_res_t picoros_shard_init(picoros_shard_t* shard, picoros_interface_t* ifx) {
+    if (shard == NULL || shard->sessions == NULL || shard->n_shards == 0) {
+        return PICOROS_ERROR;
+    }
+    for (uint8_t i = 0; i < shard->n_shards; i++) {
+        zp_task_read_options_t read_opts;
+        zp_task_read_options_default(&read_opts);
+#if Z_FEATURE_MULTI_THREAD == 1
+        read_opts.task_attributes = ifx->read_task_attr;
+#if defined(ZENOH_LINUX)
+        z_task_attr_t attr;
+        if (shard->pin_cores) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+            pthread_attr_init(&attr);
+            pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+            read_opts.task_attributes = &attr;
+        }
+#endif
+#endif
+        picoros_res_t res = session_open(&shard->sessions[i], ifx, &read_opts);
+#if Z_FEATURE_MULTI_THREAD == 1 && defined(ZENOH_LINUX)
+        if (shard->pin_cores) {
+            pthread_attr_destroy(&attr);
+        }
+#endif
+        if (res != PICOROS_OK) {
+            _PR_LOG("Unable to open shard %u session!\n", i);
+            while (i > 0) {
+                session_close(&shard->sessions[--i]);
+            }
+            return res;
+        }
+    }
+    return PICOROS_OK;
+}
+
+picoros_session_t* picoros_shard_select(picoros_shard_t* shard, const char* topic_name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*topic_name) {
+        hash = (hash ^ (uint8_t)*topic_name++) * 16777619u;
+    }
+    return &shard->sessions[hash % shard->n_shards];
+}
+
+void picoros_shard_shutdown(picoros_shard_t* shard) {
+    for (uint8_t i = 0; i < shard->n_shards; i++) {
+        session_close(&shard->sessions[i]);
+    }
+}
+
+picoros_res_t picoros_session_batch_begin(picoros_session_t* session) {
+#if Z_FEATURE_BATCHING == 1
+    return (zp_batch_start(ZSESSION(session)) == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+#else
+    return PICOROS_ERROR;
+#endif
+}
+
+picoros_res_t picoros_session_batch_flush(picoros_session_t* session) {
+#if Z_FEATURE_BATCHING == 1
+    session = SESSION(session);
+    if (__atomic_load_n(&session->_batch.automatic, __ATOMIC_ACQUIRE)) {
+        // send pending batch and keep collecting
+        batch_send(session);
+        return PICOROS_OK;
+    }
+    return (zp_batch_stop(z_session_loan(&session->zsession)) == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+#else
+    return PICOROS_OK;
+#endif
+}
+
+picoros_res_t picoros_session_batch_auto(picoros_session_t* session, const picoros_batch_cfg_t* cfg) {
+#if Z_FEATURE_BATCHING == 1
+    session = SESSION(session);
+    picoros_batch_state_t* batch = &session->_batch;
+    // stop previous configuration
+    batch_stop(session);
+    if (cfg == NULL) {
+        return PICOROS_OK;
+    }
+
+    batch->cfg = *cfg;
+    batch->pending = 0;
+    batch->epoch = z_clock_now();
+    if (zp_batch_start(z_session_loan(&session->zsession)) != Z_OK) {
+        return PICOROS_ERROR;
+    }
+    __atomic_store_n(&batch->automatic, true, __ATOMIC_RELEASE);
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (batch->cfg.max_latency_us != 0) {
+        batch->idle = false;
+        z_mutex_init(&batch->mutex);
+        z_condvar_init(&batch->cond);
+        if (z_task_init(&batch->task, NULL, batch_task, session) != Z_OK) {
+            _PR_LOG("Failed to start batch flush task!\n");
+            __atomic_store_n(&batch->automatic, false, __ATOMIC_RELEASE);
+            z_condvar_drop(z_condvar_move(&batch->cond));
+            z_mutex_drop(z_mutex_move(&batch->mutex));
+            zp_batch_stop(z_session_loan(&session->zsession));
+            return PICOROS_ERROR;
+        }
+    }
+#endif
+    return PICOROS_OK;
+#else
+    return PICOROS_ERROR;
+#endif
+}
+
+void picoros_session_batch_poll(picoros_session_t* session) {
+#if Z_FEATURE_BATCHING == 1
+    session = SESSION(session);
+    if (__atomic_load_n(&session->_batch.automatic, __ATOMIC_ACQUIRE) && batch_deadline_us(&session->_batch) == 0) {
+        batch_send(session);
+    }
+#endif
+}
+
+picoros_res_t picoros_batch_begin(void) {
+    return picoros_session_batch_begin(NULL);
+}
+
+picoros_res_t picoros_batch_flush(void) {
+    return picoros_session_batch_flush(NULL);
+}
+
+picoros_res_t picoros_batch_auto(const picoros_batch_cfg_t* cfg) {
+    return picoros_session_batch_auto(NULL, cfg);
+}
+
+void picoros_batch_poll(void) {
+    picoros_session_batch_poll(NULL);
+}
+
+picoros_res_t picoros_node_init(picoros_node_t* node) {
+    z_result_t res = Z_OK;
+    char keyexpr[KEYEXPR_SIZE];
+
+    rmw_zenoh_node_liveliness_keyexpr(node, keyexpr);
+    z_view_keyexpr_t ke;
+
+    z_view_keyexpr_from_str(&ke, keyexpr);
+
+    z_owned_liveliness_token_t token;
+
+    if ((res = z_liveliness_declare_token(ZSESSION(node->session), &token, z_view_keyexpr_loan(&ke), NULL)) != Z_OK) {
+        _PR_LOG("Unable to declare node liveliness token! Error:%d\n", res);
+        return PICOROS_ERROR;
+    }
+    return PICOROS_OK;
+}
+
+#if Z_FEATURE_MATCHING == 1
+// Matching status change, called from read task
+static void pub_matching_handler(const z_matching_status_t* status, void* ctx) {
+    picoros_publisher_t* pub = (picoros_publisher_t*)ctx;
+    __atomic_store_n(&pub->_matching, status->matching, __ATOMIC_RELAXED);
+    if (pub->matching_callback != NULL) {
+        pub->matching_callback(pub, status->matching);
+    }
+}
+#endif
+
+picoros_res_t picoros_publisher_declare(picoros_node_t* node, picoros_publisher_t* pub) {
+    z_view_keyexpr_t ke;
+    z_result_t res = Z_OK;
+    z_publisher_options_t options = pub->opts;
+    qos_publisher_options(&pub->qos, &options);
+    char keyexpr[KEYEXPR_SIZE];
+    if (pub->topic.type != NULL) {
+        rmw_zenoh_topic_keyexpr(node, &pub->topic, keyexpr);
+        z_view_keyexpr_from_str_unchecked(&ke, keyexpr);
+    }
+    else {
+        z_view_keyexpr_from_str_unchecked(&ke, pub->topic.name);
+    }
+
+    rmw_zenoh_gen_attachment_gid(&pub->attachment);
+    pub->_session = SESSION(node->session);
+    pub->_intra = NULL;
+
+    if ((res = z_declare_publisher(ZSESSION(node->session), &pub->zpub, z_view_keyexpr_loan(&ke), &options)) != Z_OK) {
+        _PR_LOG("Unable to declare publisher! Error:%d\n", res);
+        return PICOROS_ERROR;
+    }
+    if (pub->qos.durability == PICOROS_DURABILITY_TRANSIENT_LOCAL
+        && cache_declare(node, pub, z_view_keyexpr_loan(&ke)) != PICOROS_OK) {
+        z_undeclare_publisher(z_publisher_move(&pub->zpub));
+        return PICOROS_ERROR;
+    }
+
+#if Z_FEATURE_MATCHING == 1
+    z_matching_status_t status = {.matching = true};
+    z_publisher_get_matching_status(z_publisher_loan(&pub->zpub), &status);
+    pub->_matching = status.matching;
+    z_owned_closure_matching_status_t matching;
+    z_closure_matching_status(&matching, pub_matching_handler, NULL, pub);
+    if ((res = z_publisher_declare_background_matching_listener(z_publisher_loan(&pub->zpub),
+                                                                z_closure_matching_status_move(&matching))) != Z_OK) {
+        _PR_LOG("Unable to declare matching listener! Error:%d\n", res);
+        pub->_matching = true;
+    }
+#else
+    pub->_matching = true;
+#endif
+
+    if (pub->topic.type != NULL) {
+        char lv_keyexpr[KEYEXPR_SIZE];
+        z_view_keyexpr_t ke2;
+        rmw_zenoh_topic_liveliness_keyexpr(node, &pub->topic, lv_keyexpr, "MP", &pub->qos);
+        z_view_keyexpr_from_str(&ke2, lv_keyexpr);
+
+        if ((res = z_liveliness_declare_token(ZSESSION(node->session), &pub->_token, z_view_keyexpr_loan(&ke2), NULL)) != Z_OK) {
+            _PR_LOG("Unable to declare publisher liveliness token! Error:%d\n", res);
+            publisher_release(pub);
+            return PICOROS_ERROR;
+        }
+    }
+
+    // registered last, local subscribers only see fully declared publishers
+    if (pub->intra_process && intra_add_pub(pub, (pub->topic.type != NULL) ? keyexpr : pub->topic.name) != PICOROS_OK) {
+        if (pub->topic.type != NULL) {
+            z_liveliness_undeclare_token(z_liveliness_token_move(&pub->_token));
+        }
+        publisher_release(pub);
+        return PICOROS_ERROR;
+    }
+    return PICOROS_OK;
+}
+
+picoros_res_t picoros_publisher_undeclare(picoros_publisher_t* pub) {
+    if (pub->_intra != NULL) {
+        intra_remove_pub(pub);
+    }
+    if (pub->topic.type != NULL) {
+        z_liveliness_undeclare_token(z_liveliness_token_move(&pub->_token));
+    }
+    return (publisher_release(pub) == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+}
+
+// Put payload with rmw attachment and deliver it to local subscribers, takes ownership of zbytes
+static picoros_res_t publisher_put(picoros_publisher_t* pub, z_owned_bytes_t* zbytes, uint8_t* data, size_t len,
+                                   bool skip_msg) {
     z_result_t res = Z_OK;
     z_publisher_put_options_t options;
     z_publisher_put_options_default(&options);
 
     pub->attachment.sequence_number++;
-    pub->attachment.time = z_clock_now().tv_nsec;
+    pub->attachment.time = rmw_zenoh_time_ns();
 
     z_owned_bytes_t z_attachment;
     z_bytes_from_static_buf(&z_attachment, (uint8_t*)&pub->attachment, sizeof(rmw_attachment_t));
 
     options.attachment = z_bytes_move(&z_attachment);
 
+    // clone keeps loaned buffer alive for local subscribers after put
+    bool intra = intra_has_subs(pub);
+    z_owned_bytes_t local;
+    if (intra) {
+        z_bytes_clone(&local, z_bytes_loan(zbytes));
+    }
+
+    picoros_res_t ret = PICOROS_OK;
+    PICOTRACE_BEGIN(PICOTRACE_EV_PUBLISH, len);
+    res = z_publisher_put(z_publisher_loan(&pub->zpub), z_bytes_move(zbytes), &options);
+    PICOTRACE_END(PICOTRACE_EV_PUBLISH, len);
+    if (res != Z_OK) {
+        _PR_LOG("Unable to publish payload! Error:%d\n", res);
+        stats_drop(pub->stats);
+        ret = PICOROS_ERROR;
+    }
+    else {
+        stats_message(pub->stats, len);
+        batch_account(pub->_session, len);
+    }
+    if (pub->qos.durability == PICOROS_DURABILITY_TRANSIENT_LOCAL) {
+        cache_put(pub, data, len);
+    }
+
+    if (intra) {
+        intra_deliver(pub, z_bytes_loan(&local), data, len, skip_msg);
+        z_bytes_drop(z_bytes_move(&local));
+    }
+    return ret;
+}
+
+// Release loaned buffer when transport is done with it
+static void loan_deleter(void* data, void* ctx) {
+    pool_put((picoros_pool_t*)ctx, (uint8_t*)data);
+}
+
+// Publish to a topic
+picoros_res_t picoros_publish(picoros_publisher_t* pub, uint8_t* payload, size_t len) {
     z_owned_bytes_t zbytes;
     z_bytes_from_static_buf(&zbytes, payload, len);
+    return publisher_put(pub, &zbytes, payload, len, false);
+}
 
-    if ((res = z_publisher_put(z_publisher_loan(&pub->zpub), z_bytes_move(&zbytes), &options)) != Z_OK) {
-        _PR_LOG("Unable to publish payload! Error:%d\n", res);
+uint8_t* picoros_publisher_loan(picoros_publisher_t* pub, size_t size) {
+    return pool_get(pub->tx_pool, size, pub->stats);
+}
+
+// Publish loaned buffer, transport and local subscribers share it
+static picoros_res_t publish_loaned(picoros_publisher_t* pub, uint8_t* buf, size_t len, bool skip_msg) {
+    z_owned_bytes_t zbytes;
+    if (z_bytes_from_buf(&zbytes, buf, len, loan_deleter, pub->tx_pool) != Z_OK) {
+        pool_put(pub->tx_pool, buf);
         return PICOROS_ERROR;
     }
-    return PICOROS_OK;
+    return publisher_put(pub, &zbytes, buf, len, skip_msg);
+}
+
+// Serialize into loaned buffer and publish it
+static picoros_res_t publish_serialized(picoros_publisher_t* pub, size_t max_size, picoros_serialize_cb_t serialize,
+                                        void* ctx, bool skip_msg) {
+    uint8_t* buf = pool_get(pub->tx_pool, max_size, pub->stats);
+    if (buf == NULL) {
+        return PICOROS_ERROR;
+    }
+    size_t len = serialize(buf, max_size, ctx);
+    if (len == 0) {
+        pool_put(pub->tx_pool, buf);
+        return PICOROS_ERROR;
+    }
+    return publish_loaned(pub, buf, len, skip_msg);
+}
+
+picoros_res_t picoros_publish_loaned(picoros_publisher_t* pub, uint8_t* buf, size_t len) {
+    return publish_loaned(pub, buf, len, false);
+}
+
+void picoros_publisher_loan_return(picoros_publisher_t* pub, uint8_t* buf) {
+    pool_put(pub->tx_pool, buf);
+}
+
+bool picoros_publisher_has_subscribers(picoros_publisher_t* pub) {
+    return __atomic_load_n(&pub->_matching, __ATOMIC_RELAXED);
+}
+
+// Payload is needed by matching subscribers or by transient local cache for late joiners
+static bool payload_needed(picoros_publisher_t* pub) {
+    return picoros_publisher_has_subscribers(pub) || pub->qos.durability == PICOROS_DURABILITY_TRANSIENT_LOCAL;
+}
+
+picoros_res_t picoros_publish_serialized(picoros_publisher_t* pub, size_t max_size,
+                                         picoros_serialize_cb_t serialize, void* ctx) {
+    if (!payload_needed(pub) && !intra_has_subs(pub)) {
+        return PICOROS_OK;
+    }
+    return publish_serialized(pub, max_size, serialize, ctx, false);
+}
+
+picoros_res_t picoros_publish_msg(picoros_publisher_t* pub, const void* msg, size_t max_size,
+                                  picoros_serialize_cb_t serialize) {
+    bool need_payload = payload_needed(pub);
+    if (intra_has_subs(pub) && intra_deliver_msg(pub, msg)) {
+        need_payload = true;
+    }
+    if (!need_payload) {
+        return PICOROS_OK;
+    }
+    return publish_serialized(pub, max_size, serialize, (void*)msg, true);
 }
 
 // Subscribe to a topic
 picoros_res_t picoros_subscriber_declare(picoros_node_t* node, picoros_subscriber_t* sub) {
     char keyexpr[KEYEXPR_SIZE];
+    char lv_keyexpr[KEYEXPR_SIZE];
     z_view_keyexpr_t ke;
-    z_result_t res = Z_OK;
+    z_view_keyexpr_t lv_ke;
     if (sub->topic.type != NULL) {
         rmw_zenoh_topic_keyexpr(node, &sub->topic, keyexpr);
         z_view_keyexpr_from_str_unchecked(&ke, keyexpr);
+        rmw_zenoh_topic_liveliness_keyexpr(node, &sub->topic, lv_keyexpr, "MS", &sub->qos);
+        z_view_keyexpr_from_str(&lv_ke, lv_keyexpr);
     }
     else {
         z_view_keyexpr_from_str_unchecked(&ke, sub->topic.name);
     }
 
-    z_owned_closure_sample_t callback;
-    z_closure_sample(&callback, sub_data_handler, NULL, NULL);
-    callback._val.context = sub->user_callback;
-
-    if ((res = z_declare_subscriber(z_session_loan(&s_wrapper), &sub->zsub, z_view_keyexpr_loan(&ke),
-                                    z_closure_sample_move(&callback), NULL)) != Z_OK) {
-        _PR_LOG("Unable to declare subscriber! Error:%d\n", res);
+    // validate everything before subscriber is registered anywhere
+    if (sub->topic_map != NULL) {
+        picoros_topic_map_t* map = sub->topic_map;
+        if (map->entries == NULL || map->size < 4 || (map->size & (map->size - 1)) != 0) {
+            _PR_LOG("Topic map size must be power of two, at least 4!\n");
+            return PICOROS_ERROR;
+        }
+    }
+    if (sub->mailbox != NULL) {
+        picoros_mailbox_t* mb = sub->mailbox;
+        if (mb->n_slots == 0 || mb->n_slots > PICOROS_MAILBOX_MAX_SLOTS || mb->buf_size == 0) {
+            return PICOROS_ERROR;
+        }
+        if (mb->mem == NULL && (mb->mem = (uint8_t*)z_malloc(mb->n_slots * mb->buf_size)) == NULL) {
+            return PICOROS_ERROR;
+        }
+    }
+    if (sub->executor != NULL && executor_add(sub->executor, sub) != PICOROS_OK) {
         return PICOROS_ERROR;
     }
 
-    if (sub->topic.type != NULL) {
-        rmw_zenoh_topic_liveliness_keyexpr(node, &sub->topic, keyexpr, "MS");
-        z_view_keyexpr_from_str(&ke, keyexpr);
-        z_owned_liveliness_token_t token;
-        if ((res = z_liveliness_declare_token(z_session_loan(&s_wrapper), &token, z_view_keyexpr_loan(&ke), NULL)) != Z_OK) {
-            _PR_LOG("Unable to declare subscriber liveliness token! Error:%d\n", res);
-            return PICOROS_ERROR;
+    // one liveliness token per zenoh subscriber
+    sub->_shared = NULL;
+    sub->_intra = NULL;
+    if (shared_join(node, sub, (sub->topic.type != NULL) ? keyexpr : sub->topic.name, z_view_keyexpr_loan(&ke),
+                    (sub->topic.type != NULL) ? z_view_keyexpr_loan(&lv_ke) : NULL) != PICOROS_OK) {
+        if (sub->executor != NULL) {
+            executor_remove(sub->executor, sub);
         }
+        return PICOROS_ERROR;
+    }
+    if ((sub->intra_process && intra_add_sub(sub, (sub->topic.type != NULL) ? keyexpr : sub->topic.name) != PICOROS_OK)
+        || (sub->qos.durability == PICOROS_DURABILITY_TRANSIENT_LOCAL
+            && cache_query(node, sub, z_view_keyexpr_loan(&ke)) != PICOROS_OK)) {
+        picoros_unsubscribe(sub);
+        return PICOROS_ERROR;
     }
     return PICOROS_OK;
 }
@@ -411,7 +2351,7 @@ picoros_res_t picoros_service_declare(picoros_node_t* node, picoros_srv_server_t
 
     z_owned_closure_query_t callback;
     z_closure_query(&callback, queriable_data_handler, queriable_drop_handler, srv);
-    if ((res = z_declare_queryable(z_session_loan(&s_wrapper), &srv->zqable, z_view_keyexpr_loan(&ke),
+    if ((res = z_declare_queryable(ZSESSION(node->session), &srv->zqable, z_view_keyexpr_loan(&ke),
                                    z_closure_query_move(&callback), &options)) != Z_OK) {
         _PR_LOG("Unable to declare service! Error:%d\n", res);
         return PICOROS_ERROR;
@@ -419,9 +2359,9 @@ picoros_res_t picoros_service_declare(picoros_node_t* node, picoros_srv_server_t
     if (srv->topic.type != NULL) {
         z_view_keyexpr_t ke2;
         z_owned_liveliness_token_t token;
-        rmw_zenoh_topic_liveliness_keyexpr(node, &srv->topic, keyexpr, "SS");
+        rmw_zenoh_topic_liveliness_keyexpr(node, &srv->topic, keyexpr, "SS", NULL);
         z_view_keyexpr_from_str(&ke2, keyexpr);
-        if ((res = z_liveliness_declare_token(z_session_loan(&s_wrapper), &token, z_view_keyexpr_loan(&ke2), NULL)) != Z_OK) {
+        if ((res = z_liveliness_declare_token(ZSESSION(node->session), &token, z_view_keyexpr_loan(&ke2), NULL)) != Z_OK) {
             _PR_LOG("Unable to declare service liveliness token! Error:%d\n", res);
             return PICOROS_ERROR;
         }
@@ -429,10 +2369,70 @@ picoros_res_t picoros_service_declare(picoros_node_t* node, picoros_srv_server_t
     return PICOROS_OK;
 }
 
+picoros_res_t picoros_service_reply(picoros_srv_request_t* request, uint8_t* data, size_t len) {
+    if (request == NULL || request->server == NULL) {
+        return PICOROS_ERROR;
+    }
+    z_result_t res = srv_send_reply(z_query_loan(&request->_query), &request->_attachment, data, len);
+    z_query_drop(z_query_move(&request->_query));
+    srv_request_release(request);
+    return (res == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+}
+
+picoros_res_t picoros_workers_start(picoros_workers_t* workers) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (workers == NULL || workers->n_workers == 0 || workers->n_workers > PICOROS_MAX_WORKERS) {
+        return PICOROS_ERROR;
+    }
+    workers->_head = NULL;
+    workers->_tail = NULL;
+    workers->_running = true;
+    z_mutex_init(&workers->_mutex);
+    z_condvar_init(&workers->_cond);
+    for (uint8_t i = 0; i < workers->n_workers; i++) {
+        if (z_task_init(&workers->_tasks[i], NULL, worker_task, workers) != Z_OK) {
+            _PR_LOG("Failed to start service worker!\n");
+            workers->n_workers = i;
+            picoros_workers_stop(workers);
+            return PICOROS_ERROR;
+        }
+    }
+    return PICOROS_OK;
+#else
+    return PICOROS_ERROR;
+#endif
+}
+
+void picoros_workers_stop(picoros_workers_t* workers) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_mutex_lock(z_mutex_loan_mut(&workers->_mutex));
+    workers->_running = false;
+    z_condvar_signal_all(z_condvar_loan_mut(&workers->_cond));
+    z_mutex_unlock(z_mutex_loan_mut(&workers->_mutex));
+    for (uint8_t i = 0; i < workers->n_workers; i++) {
+        z_task_join(z_task_move(&workers->_tasks[i]));
+    }
+    z_condvar_drop(z_condvar_move(&workers->_cond));
+    z_mutex_drop(z_mutex_move(&workers->_mutex));
+#endif
+}
 
 picoros_res_t picoros_service_client_init(picoros_srv_client_t * client){
     if (client->_key_buf == NULL){
         client->_key_buf = z_malloc(KEYEXPR_SIZE);
+#if Z_FEATURE_MULTI_THREAD == 1
+        z_mutex_init(&client->_mutex);
+        z_condvar_init(&client->_cond);
+#endif
+    }
+    // Request slots and GID
+    client->_slot.client = client;
+    for (uint8_t i = 0; client->slots != NULL && i < client->n_slots; i++) {
+        client->slots[i].client = client;
+        client->slots[i].sequence_number = 0;
+    }
+    for (int i = 0; i < RMW_GID_SIZE; i++) {
+        client->_gid[i] = z_random_u8();
     }
     // Generate key expressions
     if (client->topic.type != NULL) {
@@ -446,13 +2446,37 @@ picoros_res_t picoros_service_client_init(picoros_srv_client_t * client){
     else {
         z_view_keyexpr_from_str_unchecked(&client->ke, client->topic.name);
     }
+
+    // Querier for repeated calls, routing is resolved once
+    if (!client->use_get && !client->_has_querier) {
+        z_querier_options_t opts;
+        z_querier_options_default(&opts);
+        if (client->opts != NULL) {
+            opts.target = client->opts->target;
+            opts.consolidation = client->opts->consolidation;
+            opts.congestion_control = client->opts->congestion_control;
+            opts.priority = client->opts->priority;
+            opts.is_express = client->opts->is_express;
+            opts.timeout_ms = client->opts->timeout_ms;
+        }
+        if (client->timeout_ms != 0) {
+            opts.timeout_ms = client->timeout_ms;
+        }
+        client->_querier_timeout_ms = opts.timeout_ms;
+        z_result_t res = z_declare_querier(ZSESSION(client->session), &client->_querier,
+                                           z_view_keyexpr_loan(&client->ke), &opts);
+        if (res != Z_OK) {
+            _PR_LOG("Unable to declare %s querier, using get! Error:%d\n", client->topic.name, res);
+        }
+        client->_has_querier = (res == Z_OK);
+    }
     return PICOROS_OK;
 }
 
 
-picoros_res_t picoros_service_call(picoros_srv_client_t * client, uint8_t* payload, size_t len){
-    if (client == NULL) { return PICOROS_ERROR;}
-    if (client->_in_progress) { return PICOROS_NOT_READY;}
+// Start request in a free slot, sync is set for synchronous calls
+static picoros_res_t service_call(picoros_srv_client_t * client, uint8_t* payload, size_t len, int64_t* seq,
+                                  sync_call_t* sync, uint32_t timeout_ms, picoros_srv_slot_t** claimed){
 
     z_result_t res;
 
@@ -461,51 +2485,353 @@ picoros_res_t picoros_service_call(picoros_srv_client_t * client, uint8_t* paylo
         picoros_service_client_init(client);
     }
 
-    // Default options
-    z_get_options_t default_opts;
-    z_get_options_default(&default_opts);
-    z_get_options_t* opts = &default_opts;
-    if (client->opts != NULL){
-        opts = client->opts;
+    // Claim free request slot and a free query context of it
+    int64_t sequence_number = __atomic_add_fetch(&client->_next_seq, 1, __ATOMIC_RELAXED);
+    picoros_srv_slot_t* slot = NULL;
+    picoros_srv_query_t* query = NULL;
+    picoros_srv_slot_t* slots = (client->slots != NULL) ? client->slots : &client->_slot;
+    uint8_t n_slots = (client->slots != NULL) ? client->n_slots : 1;
+    for (uint8_t i = 0; i < n_slots && slot == NULL; i++) {
+        int64_t free_seq = 0;
+        if (!__atomic_compare_exchange_n(&slots[i].sequence_number, &free_seq, sequence_number, false,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        query = slot_query_claim(&slots[i], sequence_number);
+        if (query == NULL) {
+            // queries of timed out calls still pending
+            slot_release(&slots[i], sequence_number);
+            continue;
+        }
+        slot = &slots[i];
     }
-
-    // Payload
-    z_owned_bytes_t zbytes;
-    z_bytes_copy_from_buf(&zbytes, payload, len);
-    opts->payload = z_bytes_move(&zbytes);
+    if (slot == NULL) { return PICOROS_NOT_READY;}
+    query->is_sync = (sync != NULL);
+    slot->sync = sync;
 
     // RMW attachment
     rmw_attachment_t attachment = {
         .rmw_gid_size = RMW_GID_SIZE,
-        .sequence_number = 1,
-        .time = z_clock_now().tv_nsec,
+        .sequence_number = sequence_number,
+        .time = rmw_zenoh_time_ns(),
     };
-    z_owned_bytes_t tx_attachment;
-    z_bytes_copy_from_buf(&tx_attachment, (uint8_t*)&attachment, sizeof(rmw_attachment_t));
-    opts->attachment = z_bytes_move(&tx_attachment);
+    memcpy(attachment.rmw_gid, client->_gid, RMW_GID_SIZE);
 
     // Closure
     z_owned_closure_reply_t callback = {
         ._val.call = get_data_handler,
         ._val.drop = get_drop_handler,
-        ._val.context = client,
+        ._val.context = query,
     };
 
-    client->_in_progress = true;
-    if ((res = z_get(z_session_loan(&s_wrapper), z_view_keyexpr_loan(&client->ke), "", z_closure_reply_move(&callback), opts)) != Z_OK) {
+    z_owned_bytes_t zbytes;
+    z_owned_bytes_t tx_attachment;
+    // querier has fixed request timeout, shorter synchronous calls stop waiting before it, longer ones use z_get
+    if (client->_has_querier && (sync == NULL || timeout_ms <= client->_querier_timeout_ms)) {
+        // Request is sent before returning, payload and attachment don't need copies
+        z_bytes_from_static_buf(&zbytes, payload, len);
+        z_bytes_from_static_buf(&tx_attachment, (uint8_t*)&attachment, sizeof(rmw_attachment_t));
+        z_querier_get_options_t qopts;
+        z_querier_get_options_default(&qopts);
+        qopts.payload = z_bytes_move(&zbytes);
+        qopts.attachment = z_bytes_move(&tx_attachment);
+        res = z_querier_get(z_querier_loan(&client->_querier), "", z_closure_reply_move(&callback), &qopts);
+    }
+    else {
+        // Client or default options, synchronous calls time out with caller
+        z_get_options_t opts;
+        if (client->opts != NULL){
+            opts = *client->opts;
+        }
+        else{
+            z_get_options_default(&opts);
+        }
+        if (sync != NULL && timeout_ms != 0){
+            opts.timeout_ms = timeout_ms;
+        }
+        z_bytes_copy_from_buf(&zbytes, payload, len);
+        opts.payload = z_bytes_move(&zbytes);
+        z_bytes_copy_from_buf(&tx_attachment, (uint8_t*)&attachment, sizeof(rmw_attachment_t));
+        opts.attachment = z_bytes_move(&tx_attachment);
+        res = z_get(ZSESSION(client->session), z_view_keyexpr_loan(&client->ke), "", z_closure_reply_move(&callback), &opts);
+    }
+
+    if (res != Z_OK) {
         _PR_LOG("Error calling %s service! Error:%d\n", client->topic.name, res);
-        client->_in_progress = false;
-        z_bytes_drop(opts->attachment);
-        z_bytes_drop(opts->payload);
+        // release query and slot unless drop handler already did
+        int64_t own_seq = sequence_number;
+        __atomic_compare_exchange_n(&query->sequence_number, &own_seq, 0, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        slot_release(slot, sequence_number);
+        return PICOROS_ERROR;
+    }
+    if (seq != NULL) {
+        *seq = sequence_number;
+    }
+    if (claimed != NULL) {
+        *claimed = slot;
+    }
+    return PICOROS_OK;
+}
+
+picoros_res_t picoros_service_call(picoros_srv_client_t * client, uint8_t* payload, size_t len){
+    return picoros_service_call_seq(client, payload, len, NULL);
+}
+
+picoros_res_t picoros_service_call_seq(picoros_srv_client_t * client, uint8_t* payload, size_t len, int64_t* seq){
+    if (client == NULL) { return PICOROS_ERROR;}
+    return service_call(client, payload, len, seq, NULL, 0, NULL);
+}
+
+picoros_res_t picoros_service_call_sync(picoros_srv_client_t* client, uint8_t* payload, size_t len,
+                                        uint8_t* reply_buf, size_t* reply_len, uint32_t timeout_ms){
+    if (client == NULL || reply_buf == NULL || reply_len == NULL) { return PICOROS_ERROR;}
+
+    sync_call_t sync = {
+        .buf = reply_buf,
+        .size = *reply_len,
+    };
+    *reply_len = 0;
+    picoros_srv_slot_t* slot = NULL;
+    int64_t seq = 0;
+    picoros_res_t res = service_call(client, payload, len, &seq, &sync, timeout_ms, &slot);
+    if (res != PICOROS_OK) {
+        return res;
+    }
+
+    // Wait for reply or drop
+    z_clock_t start = z_clock_now();
+    SYNC_LOCK(client);
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_clock_t deadline = start;
+    z_clock_advance_ms(&deadline, timeout_ms);
+    while (!sync.done) {
+        if (z_condvar_timedwait(z_condvar_loan_mut(&client->_cond), z_mutex_loan_mut(&client->_mutex), &deadline) != Z_OK) {
+            break;
+        }
+    }
+#else
+    while (!sync.done && z_clock_elapsed_ms(&start) < timeout_ms) {
+        zp_read(ZSESSION(client->session), NULL);
+    }
+#endif
+    if (!sync.done) {
+        // stop waiting and free slot for next call, late reply and drop of this request are ignored
+        slot->sync = NULL;
+        slot_release(slot, seq);
+    }
+    SYNC_UNLOCK(client);
+
+    if (!sync.replied) {
+        return PICOROS_TIMEOUT;
+    }
+    *reply_len = sync.len;
+    if (sync.error || sync.len > sync.size) {
         return PICOROS_ERROR;
     }
     return PICOROS_OK;
 }
 
 bool picoros_service_call_in_progress(picoros_srv_client_t* client){
-    return client->_in_progress;
+    if (client->slots == NULL) {
+        return __atomic_load_n(&client->_slot.sequence_number, __ATOMIC_ACQUIRE) != 0;
+    }
+    for (uint8_t i = 0; i < client->n_slots; i++) {
+        if (__atomic_load_n(&client->slots[i].sequence_number, __ATOMIC_ACQUIRE) != 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 picoros_res_t picoros_unsubscribe(picoros_subscriber_t* sub) {
-    return (z_undeclare_subscriber(z_subscriber_move(&sub->zsub)) == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+    picoros_res_t res;
+    if (sub->_shared != NULL) {
+        res = shared_leave(sub);
+    }
+    else {
+        if (sub->topic.type != NULL) {
+            z_liveliness_undeclare_token(z_liveliness_token_move(&sub->_token));
+        }
+        res = (z_undeclare_subscriber(z_subscriber_move(&sub->zsub)) == Z_OK) ? PICOROS_OK : PICOROS_ERROR;
+    }
+    if (sub->_intra != NULL) {
+        intra_remove_sub(sub);
+    }
+    if (sub->executor != NULL) {
+        executor_remove(sub->executor, sub);
+    }
+    return res;
+}
+
+void picoros_topic_map_clear(picoros_topic_map_t* map) {
+    for (uint16_t i = 0; i < map->size; i++) {
+        z_free(map->entries[i].keyexpr);
+        memset(&map->entries[i], 0, sizeof(map->entries[i]));
+    }
+    map->_count = 0;
+}
+
+uint8_t picoros_seq_stats(picoros_subscriber_t* sub, picoros_seq_stats_t* stats, uint8_t max) {
+    picoros_seq_tracker_t* tr = sub->seq_tracker;
+    if (tr == NULL || stats == NULL) {
+        return 0;
+    }
+    seq_lock(tr);
+    uint8_t n = (tr->_count < max) ? tr->_count : max;
+    memcpy(stats, tr->publishers, n * sizeof(picoros_seq_stats_t));
+    seq_unlock(tr);
+    return n;
+}
+
+void picoros_seq_stats_reset(picoros_subscriber_t* sub) {
+    picoros_seq_tracker_t* tr = sub->seq_tracker;
+    if (tr == NULL) {
+        return;
+    }
+    seq_lock(tr);
+    memset(tr->publishers, 0, sizeof(tr->publishers));
+    tr->untracked = 0;
+    tr->_count = 0;
+    seq_unlock(tr);
+}
+
+picoros_res_t picoros_take_latest(picoros_subscriber_t* sub, uint8_t* buf, size_t size, size_t* len) {
+    picoros_mailbox_t* mb = sub->mailbox;
+    if (mb == NULL || buf == NULL || len == NULL) {
+        return PICOROS_ERROR;
+    }
+    for (;;) {
+        uint32_t written = __atomic_load_n(&mb->_written, __ATOMIC_ACQUIRE);
+        if (written == __atomic_load_n(&mb->_taken, __ATOMIC_RELAXED)) {
+            return PICOROS_NOT_READY;
+        }
+        uint8_t slot = (written - 1) % mb->n_slots;
+        uint32_t seq = __atomic_load_n(&mb->_seq[slot], __ATOMIC_ACQUIRE);
+        if (seq & 1u) {
+            continue; // being written
+        }
+        size_t sample_len = __atomic_load_n(&mb->_len[slot], __ATOMIC_RELAXED);
+        if (sample_len > size) {
+            return PICOROS_ERROR;
+        }
+        memcpy(buf, mb->mem + slot * mb->buf_size, sample_len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&mb->_seq[slot], __ATOMIC_RELAXED) != seq) {
+            continue; // overwritten while copying
+        }
+        *len = sample_len;
+        __atomic_store_n(&mb->_taken, written, __ATOMIC_RELAXED);
+        return PICOROS_OK;
+    }
+}
+
+picoros_res_t picoros_executor_start(picoros_executor_t* executor) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (executor == NULL || executor->n_workers == 0 || executor->n_workers > PICOROS_MAX_WORKERS) {
+        return PICOROS_ERROR;
+    }
+    executor->_idle = 0;
+    executor->_started = 0;
+    executor->_running = true;
+    z_mutex_init(&executor->_mutex);
+    z_condvar_init(&executor->_cond);
+    for (uint8_t i = 0; i < executor->n_workers; i++) {
+        if (z_task_init(&executor->_tasks[i], NULL, executor_task, executor) != Z_OK) {
+            _PR_LOG("Failed to start executor worker!\n");
+            executor->n_workers = i;
+            picoros_executor_stop(executor);
+            return PICOROS_ERROR;
+        }
+    }
+    return PICOROS_OK;
+#else
+    return PICOROS_ERROR;
+#endif
+}
+
+void picoros_executor_stop(picoros_executor_t* executor) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_mutex_lock(z_mutex_loan_mut(&executor->_mutex));
+    __atomic_store_n(&executor->_running, false, __ATOMIC_RELEASE);
+    z_condvar_signal_all(z_condvar_loan_mut(&executor->_cond));
+    z_mutex_unlock(z_mutex_loan_mut(&executor->_mutex));
+    for (uint8_t i = 0; i < executor->n_workers; i++) {
+        z_task_join(z_task_move(&executor->_tasks[i]));
+    }
+    z_condvar_drop(z_condvar_move(&executor->_cond));
+    z_mutex_drop(z_mutex_move(&executor->_mutex));
+#endif
+}
+
+uint32_t picoros_executor_spin_once(picoros_executor_t* executor) {
+    return executor_run(executor, &executor->_epochs[PICOROS_MAX_WORKERS], 0, 1);
+}
+
+bool picoros_rx_view_next(void* view, const uint8_t** data, size_t* len) {
+    z_view_slice_t slice;
+    if (!z_bytes_slice_iterator_next(&((picoros_rx_view_t*)view)->_it, &slice)) {
+        return false;
+    }
+    *data = z_slice_data(z_view_slice_loan(&slice));
+    *len = z_slice_len(z_view_slice_loan(&slice));
+    return true;
+}
+
+// Histogram bucket of value, linear below 2^sub_bits then sub_bits significant bits per power of two
+static uint32_t latency_bucket(uint32_t value) {
+    if (value < (1u << PICOROS_LATENCY_SUB_BITS)) {
+        return value;
+    }
+    uint32_t msb = 31u - (uint32_t)__builtin_clz(value);
+    uint32_t shift = msb - PICOROS_LATENCY_SUB_BITS;
+    uint32_t sub = (value >> shift) & ((1u << PICOROS_LATENCY_SUB_BITS) - 1u);
+    return ((shift + 1u) << PICOROS_LATENCY_SUB_BITS) + sub;
+}
+
+// Largest value of histogram bucket
+static uint32_t latency_bucket_max(uint32_t bucket) {
+    if (bucket < (1u << PICOROS_LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+    uint32_t shift = (bucket >> PICOROS_LATENCY_SUB_BITS) - 1u;
+    uint64_t sub = (bucket & ((1u << PICOROS_LATENCY_SUB_BITS) - 1u)) | (1u << PICOROS_LATENCY_SUB_BITS);
+    uint64_t max = ((sub + 1u) << shift) - 1u;
+    return max > UINT32_MAX ? UINT32_MAX : (uint32_t)max;
+}
+
+void picoros_latency_record(picoros_latency_hist_t* hist, uint32_t latency_us) {
+    __atomic_fetch_add(&hist->counts[latency_bucket(latency_us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->sum_us, latency_us, __ATOMIC_RELAXED);
+    if (__atomic_fetch_add(&hist->total, 1, __ATOMIC_RELAXED) == 0) {
+        __atomic_store_n(&hist->min_us, latency_us, __ATOMIC_RELAXED);
+    }
+    uint32_t min = __atomic_load_n(&hist->min_us, __ATOMIC_RELAXED);
+    while (latency_us < min &&
+           !__atomic_compare_exchange_n(&hist->min_us, &min, latency_us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    uint32_t max = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+    while (latency_us > max &&
+           !__atomic_compare_exchange_n(&hist->max_us, &max, latency_us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+uint32_t picoros_latency_percentile(const picoros_latency_hist_t* hist, double percentile) {
+    uint32_t total = __atomic_load_n(&hist->total, __ATOMIC_RELAXED);
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(percentile / 100.0 * total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < PICOROS_LATENCY_BUCKETS; i++) {
+        count += __atomic_load_n(&hist->counts[i], __ATOMIC_RELAXED);
+        if (count >= rank) {
+            uint32_t max = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+            uint32_t bound = latency_bucket_max(i);
+            return bound < max ? bound : max;
+        }
+    }
+    return __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
 }
@@ -55,7 +55,7 @@
  */
 typedef struct __attribute__((__packed__)) {
     int64_t  sequence_number;       /**< Message sequence number */
-    int64_t  time;                  /**< Timestamp */
+    int64_t  time;                  /**< Source timestamp in nanoseconds since epoch */
     uint8_t  rmw_gid_size;          /**< Size of RMW GID */
     uint8_t  rmw_gid[RMW_GID_SIZE]; /**< RMW Global Identifier */
 } rmw_attachment_t;
@@ -69,6 +69,175 @@ typedef struct {
     const char* rihs_hash;          /**< RIHS hash */
 } rmw_topic_t;
 
+/**
+ * @brief ROS reliability QoS policy, values as in rmw
+ */
+typedef enum {
+    PICOROS_RELIABILITY_DEFAULT = 0,    /**< rmw default */
+    PICOROS_RELIABILITY_RELIABLE,       /**< Reliable, publisher blocks on congestion with keep all history */
+    PICOROS_RELIABILITY_BEST_EFFORT,    /**< Best effort, publications are dropped on congestion */
+} picoros_reliability_t;
+
+/**
+ * @brief ROS durability QoS policy, values as in rmw
+ */
+typedef enum {
+    PICOROS_DURABILITY_DEFAULT = 0,     /**< rmw default */
+    PICOROS_DURABILITY_TRANSIENT_LOCAL, /**< Late joining subscribers get publisher history */
+    PICOROS_DURABILITY_VOLATILE,        /**< Only new publications are received */
+} picoros_durability_t;
+
+/**
+ * @brief ROS history QoS policy, values as in rmw
+ */
+typedef enum {
+    PICOROS_HISTORY_DEFAULT = 0,        /**< rmw default */
+    PICOROS_HISTORY_KEEP_LAST,          /**< Keep up to depth messages */
+    PICOROS_HISTORY_KEEP_ALL,           /**< Keep all messages */
+} picoros_history_t;
+
+/**
+ * @brief ROS QoS profile of a topic
+ * @details Zero initialized profile advertises rmw defaults and leaves zenoh options unchanged.
+ *          Policies are encoded in liveliness token. Reliability and history select zenoh
+ *          congestion control, priority selects zenoh priority lane.
+ */
+typedef struct {
+    picoros_reliability_t reliability;  /**< Reliability policy */
+    picoros_durability_t  durability;   /**< Durability policy */
+    picoros_history_t     history;      /**< History policy */
+    uint32_t              depth;        /**< History depth, 0 for default */
+    z_priority_t          priority;     /**< Zenoh priority, 0 for default. Real time and interactive high are sent express */
+    uint32_t              deadline_ms;  /**< Maximum expected period between messages, 0 for infinite */
+} picoros_qos_t;
+
+/** @} */
+
+/**
+ * @defgroup stats Statistics
+ * @ingroup picoros
+ * @{
+ */
+
+/** @brief Number of callback duration histogram buckets */
+#define PICOROS_STATS_CB_BUCKETS 16u
+
+/**
+ * @brief Runtime counters of a publisher, subscriber or service server
+ * @details Updated lock-free on the data path of entities they are set on and read with
+ *          picostats API. Callback durations are counted in power of two buckets, bucket 0
+ *          holds durations below 1 us, bucket n from 2^(n-1) us and last bucket all longer ones.
+ */
+typedef struct {
+    uint32_t messages;          /**< Published messages, accepted samples or handled requests */
+    uint64_t bytes;             /**< Payload bytes of messages */
+    uint32_t dropped;           /**< Messages dropped by throttle, filter, full queue, missing buffer or failed put */
+    uint32_t allocations;       /**< Heap allocations of message buffers */
+    uint32_t callbacks;         /**< Number of timed user callbacks */
+    uint64_t callback_us;       /**< Total duration of user callbacks */
+    uint32_t callback_max_us;   /**< Longest user callback */
+    uint32_t callback_hist[PICOROS_STATS_CB_BUCKETS];  /**< User callback duration histogram */
+} picoros_stats_t;
+
+/** @} */
+
+/**
+ * @defgroup pool Buffer pool
+ * @ingroup picoros
+ * @{
+ */
+
+/** @brief Maximum number of buffers in a pool */
+#define PICOROS_POOL_MAX_BUFFERS 32u
+
+/**
+ * @brief Handling of messages that don't fit in pool buffer or arrive when all buffers are used
+ */
+typedef enum {
+    PICOROS_POOL_DROP = 0,          /**< Count and drop message */
+    PICOROS_POOL_HEAP,              /**< Count and use heap allocated buffer */
+} picoros_pool_policy_t;
+
+/**
+ * @brief Fixed pool of equally sized message buffers
+ * @details Can be shared between entities. Pool with user supplied memory can be used
+ *          without initialization, otherwise memory is allocated once by picoros_pool_init().
+ */
+typedef struct {
+    uint8_t*              mem;              /**< Buffer memory of buf_count * buf_size bytes, allocated if NULL */
+    size_t                buf_size;         /**< Size of one buffer, maximum message size */
+    uint8_t               buf_count;        /**< Number of buffers, only first PICOROS_POOL_MAX_BUFFERS are used */
+    picoros_pool_policy_t policy;           /**< Policy for messages not fitting in pool */
+    uint32_t              dropped;          /**< Number of dropped messages */
+    uint32_t              heap_fallbacks;   /**< Number of messages using heap buffer */
+    uint32_t              _used;            /**< Private bitmask of used buffers */
+} picoros_pool_t;
+
+/** @} */
+
+/**
+ * @defgroup batching Batching
+ * @ingroup picoros
+ * @{
+ */
+
+/**
+ * @brief Automatic batching configuration
+ * @details Publications are collected to a single transport batch and sent when one of the limits is reached.
+ */
+typedef struct {
+    size_t   max_bytes;             /**< Flush when pending payload reaches this size, 0 for no limit */
+    uint32_t max_latency_us;        /**< Flush when oldest pending publication is this old, 0 for no limit */
+} picoros_batch_cfg_t;
+
+/** @} */
+
+/**
+ * @defgroup session Session
+ * @ingroup picoros
+ * @{
+ */
+
+/**
+ * @brief Private automatic batching state of a session
+ */
+typedef struct {
+    picoros_batch_cfg_t cfg;            /**< Automatic batching limits */
+    bool                automatic;      /**< Automatic batching enabled */
+    z_clock_t           epoch;          /**< Reference for timestamps below */
+    uint64_t            first_us;       /**< Time of first pending publication */
+    size_t              pending;        /**< Payload bytes in current batch */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_owned_task_t      task;           /**< Latency flush task */
+    z_owned_mutex_t     mutex;          /**< Protects idle wait of flush task */
+    z_owned_condvar_t   cond;           /**< Wakes idle flush task on first pending publication */
+    bool                idle;           /**< Flush task waits for a publication */
+#endif
+} picoros_batch_state_t;
+
+/**
+ * @brief Zenoh session with its own read and lease tasks
+ * @details Entities declared on different sessions don't share transport and read task, so
+ *          traffic on one session can't block delivery on another. Entities use the session
+ *          of their node, NULL session pointer selects the default session.
+ */
+typedef struct picoros_session_s {
+    z_owned_session_t     zsession;     /**< Zenoh session instance */
+    picoros_batch_state_t _batch;       /**< Private batching state */
+} picoros_session_t;
+
+/**
+ * @brief Set of sessions for pinning topics to separate transports and read tasks
+ * @details Typically one shard per core, high rate topics get a shard of their own so they
+ *          don't head-of-line block control topics. Entities are pinned to a shard by
+ *          declaring them on a node using that shard session.
+ */
+typedef struct {
+    picoros_session_t*  sessions;       /**< Array of n_shards sessions */
+    uint8_t             n_shards;       /**< Number of shards */
+    bool                pin_cores;      /**< Pin read task of shard i to core i (Linux only) */
+} picoros_shard_t;
+
 /** @} */
 
 /**
@@ -77,6 +246,11 @@ typedef struct {
  * @{
  */
 
+/** @brief Maximum number of pending deferred requests per server */
+#define PICOROS_SRV_MAX_PENDING 32u
+/** @brief Maximum number of threads in a worker pool */
+#define PICOROS_MAX_WORKERS 8u
+
 /* Forward declaration */
 struct picoros_srv_server_s;
 
@@ -100,6 +274,46 @@ typedef picoros_service_reply_t (*picoros_srv_server_cb_t)(
     size_t                       reqest_size     /**< Request data size */
 );
 
+/**
+ * @brief Handle of a deferred service request
+ * @details Holds a clone of the query until picoros_service_reply() is called, can be
+ *          replied from any thread. Storage is supplied by the server, fields are read only.
+ */
+typedef struct picoros_srv_request_s {
+    struct picoros_srv_server_s*  server;       /**< Server that received the request */
+    uint8_t*                      data;         /**< Request data (CDR encoded) */
+    size_t                        len;          /**< Request data size */
+    z_owned_query_t               _query;       /**< Private cloned query */
+    rmw_attachment_t              _attachment;  /**< Private reply attachment */
+    struct picoros_srv_request_s* _next;        /**< Private worker queue link */
+} picoros_srv_request_t;
+
+/**
+ * @brief Callback function type for deferred service request handling
+ * @details Reply is sent later with picoros_service_reply(), possibly from another thread.
+ */
+typedef void (*picoros_srv_deferred_cb_t)(
+    struct picoros_srv_server_s* server,         /**< Pointer to server instance */
+    picoros_srv_request_t*       request         /**< Request handle, valid until replied */
+);
+
+/**
+ * @brief Pool of worker threads processing deferred service requests
+ * @details Can be shared between servers. Requests are processed in arrival order by
+ *          n_workers threads, so a slow service doesn't block the zenoh read task.
+ */
+typedef struct {
+    uint8_t                 n_workers;                      /**< Number of worker threads, up to PICOROS_MAX_WORKERS */
+    picoros_srv_request_t*  _head;                          /**< Private queue head */
+    picoros_srv_request_t*  _tail;                          /**< Private queue tail */
+    bool                    _running;                       /**< Private run flag */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_owned_mutex_t         _mutex;                         /**< Private queue lock */
+    z_owned_condvar_t       _cond;                          /**< Private queue signal */
+    z_owned_task_t          _tasks[PICOROS_MAX_WORKERS];    /**< Private worker threads */
+#endif
+} picoros_workers_t;
+
 /**
  * @brief Service server structure for Pico-ROS
  */
@@ -109,6 +323,14 @@ typedef struct picoros_srv_server_s{
     rmw_attachment_t         attachment;     /**< RMW attachment data */
     void*                    user_data;      /**< User data, not used by picoros */
     picoros_srv_server_cb_t  user_callback;  /**< User callback for service handling */
+    picoros_pool_t*          rx_pool;        /**< Request buffer pool, if NULL heap is used */
+    picoros_srv_deferred_cb_t deferred_callback; /**< Deferred request callback, used instead of user_callback if set */
+    picoros_srv_request_t*   requests;       /**< Handles for deferred requests, max_pending of them */
+    uint8_t                  max_pending;    /**< Maximum requests waiting for reply, up to PICOROS_SRV_MAX_PENDING */
+    picoros_workers_t*       workers;        /**< Worker pool for deferred requests, if NULL callback runs on read task */
+    uint32_t                 rejected;       /**< Number of requests rejected with error reply because max_pending was reached */
+    picoros_stats_t*         stats;          /**< Runtime counters, if NULL not collected */
+    uint32_t                 _pending;       /**< Private bitmask of used request handles */
 } picoros_srv_server_t;
 
 /** @} */
@@ -120,8 +342,12 @@ typedef struct picoros_srv_server_s{
  * @{
  */
 
+/** @brief Zenoh queries per request slot, a timed out synchronous call keeps one pending while slot is reused */
+#define PICOROS_SRV_SLOT_QUERIES 2u
+
 /* Forward declaration */
 struct picoros_srv_client_s;
+struct picoros_srv_slot_s;
 
 /**
  * @brief Callback function type for service reply handling
@@ -141,6 +367,25 @@ typedef void (*picoros_srv_client_cb_t)(
  */
 typedef void (*picoros_srv_client_drop_cb_t)( struct picoros_srv_client_s* client);
 
+/**
+ * @brief Zenoh query sent from a request slot, contents are private
+ */
+typedef struct {
+    struct picoros_srv_slot_s*    slot;            /**< Slot that sent the query */
+    int64_t                       sequence_number; /**< Sequence number of request, 0 once query is dropped */
+    bool                          is_sync;         /**< Request made by picoros_service_call_sync() */
+} picoros_srv_query_t;
+
+/**
+ * @brief Slot for one in-flight service request, contents are private
+ */
+typedef struct picoros_srv_slot_s {
+    struct picoros_srv_client_s*  client;          /**< Client owning the slot */
+    int64_t                       sequence_number; /**< Sequence number of in-flight request, 0 if slot is free */
+    void*                         sync;            /**< Waiting synchronous call, NULL when caller stopped waiting */
+    picoros_srv_query_t           _queries[PICOROS_SRV_SLOT_QUERIES]; /**< Private closure contexts of queries */
+} picoros_srv_slot_t;
+
 
 /**
 * @brief Service client structure for Pico-ROS
@@ -151,23 +396,86 @@ typedef struct picoros_srv_client_s{
     rmw_topic_t                   topic;                 /**< Topic information */
     picoros_srv_client_cb_t       user_callback;         /**< User callback for service reply handling. Called if reply is received. */
     picoros_srv_client_drop_cb_t  drop_callback;         /**< User callback for service call drop handling. Called for every service call.*/
-    bool                          _in_progress;          /**< Private flag used to limit to one ongoing request */
-    z_get_options_t*              opts;                  /**< Request options, if NULL default options are used */
+    picoros_srv_slot_t*           slots;                 /**< Table of n_slots for pipelined requests, if NULL one request at a time */
+    uint8_t                       n_slots;               /**< Maximum number of in-flight requests when slots is set */
+    int64_t                       reply_seq;             /**< Sequence number of request user_callback/drop_callback is called for */
+    picoros_srv_slot_t            _slot;                 /**< Private slot used when slots is NULL */
+    int64_t                       _next_seq;             /**< Private request sequence counter */
+    uint8_t                       _gid[RMW_GID_SIZE];    /**< Private client GID sent in request attachment */
+    z_owned_querier_t             _querier;              /**< Private querier used for calls */
+    bool                          _has_querier;          /**< Private flag, querier is declared */
+    uint64_t                      _querier_timeout_ms;   /**< Private request timeout of querier */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_owned_mutex_t               _mutex;                /**< Private lock for synchronous calls */
+    z_owned_condvar_t             _cond;                 /**< Private synchronous call completion signal */
+#endif
+    z_get_options_t*              opts;                  /**< Request options, if NULL default options are used. Applied to querier at init. */
+    bool                          use_get;               /**< Issue every call with z_get instead of declaring a querier at init */
+    uint32_t                      timeout_ms;            /**< Request timeout of querier, if 0 opts or zenoh default timeout is used */
     void*                         user_data;             /**< User data, not used by picoros */
     z_view_keyexpr_t              ke;                    /**< Precomputed when creating the client */
     char*                         _key_buf;              /**< Private buffer for key expresion */
+    picoros_pool_t*               rx_pool;               /**< Reply buffer pool, if NULL heap is used */
+    picoros_session_t*            session;               /**< Session used for calls, if NULL default session is used */
 } picoros_srv_client_t;
 
 /** @} */
 
+/** @brief Maximum number of topics in registry of intra-process and shared subscriptions */
+#define PICOROS_INTRA_MAX_TOPICS 32u
+
+/* Forward declaration, registry topic */
+struct picoros_intra_topic_s;
+
 /**
- * @brief Publisher structure for Pico-ROS @ingroup picoros
+ * @brief Transient local publication cache
+ * @details Keeps last qos.depth publications of a publisher with transient local durability
+ *          within a fixed memory budget, oldest are evicted first. Cached publications are
+ *          sent as replies to queries on the topic, e.g. of late joining subscribers.
  */
 typedef struct {
+    uint8_t*            mem;            /**< Cache memory of size bytes, allocated at declare if NULL */
+    size_t              size;           /**< Memory budget, each publication also takes a small record header */
+    uint32_t            evicted;        /**< Number of publications evicted before depth was reached */
+    uint32_t            oversize;       /**< Number of publications larger than cache */
+    uint32_t            _count;         /**< Private number of cached publications */
+    size_t              _first;         /**< Private offset of oldest record */
+    size_t              _next;          /**< Private offset of next record */
+    size_t              _wrap;          /**< Private end of records before wrap, 0 if not wrapped */
+    z_owned_queryable_t _zqable;        /**< Private queryable answering with cached publications */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_owned_mutex_t     _mutex;         /**< Private lock between publisher and read task */
+#endif
+} picoros_pub_cache_t;
+
+/**
+ * @brief Serialization callback for picoros_publish_serialized()
+ * @param buf Buffer to serialize message into
+ * @param size Size of buf
+ * @param ctx User context
+ * @return Size of serialized message, 0 on error
+ */
+typedef size_t (*picoros_serialize_cb_t)(uint8_t* buf, size_t size, void* ctx);
+
+/**
+ * @brief Publisher structure for Pico-ROS @ingroup picoros
+ */
+typedef struct picoros_publisher_s {
     z_owned_publisher_t zpub;       /**< Zenoh publisher instance */
     rmw_attachment_t   attachment;  /**< RMW attachment data */
     rmw_topic_t        topic;       /**< Topic information */
     z_publisher_options_t opts;     /**< Topic options, if NULL default options are used */
+    picoros_qos_t      qos;         /**< QoS profile, overrides opts for policies that are set */
+    picoros_pub_cache_t* cache;     /**< Publication cache, required with transient local durability */
+    picoros_pool_t*    tx_pool;     /**< Pool for loaned buffers, if NULL loans are allocated from heap */
+    void (*matching_callback)(struct picoros_publisher_s* pub, bool matching); /**< Called when first subscriber matches or last one leaves */
+    bool               intra_process; /**< Deliver directly to intra_process subscribers of same topic in this process */
+    picoros_stats_t*   stats;       /**< Runtime counters, if NULL not collected */
+    picoros_session_t* _session;    /**< Private session the publisher is declared on */
+    z_owned_liveliness_token_t _token; /**< Private liveliness token, declared for typed topics */
+    bool               _matching;   /**< Private matching status */
+    struct picoros_intra_topic_s* _intra;      /**< Private intra-process registry topic */
+    struct picoros_publisher_s*   _intra_next; /**< Private next publisher of registry topic */
 } picoros_publisher_t;
 
 /** @} */
@@ -179,6 +487,9 @@ typedef struct {
  * @{
  */
 
+/* Forward declaration */
+struct picoros_subscriber_s;
+
 /**
  * @brief Callback function type for subscriber data handling
  */
@@ -188,12 +499,267 @@ typedef void (*picoros_sub_cb_t)(
             );
 
 /**
- * @brief Subscriber structure for Pico-ROS
+ * @brief Callback function type for intra-process typed message handling
+ */
+typedef void (*picoros_sub_msg_cb_t)(
+            struct picoros_subscriber_s* sub,   /**< Pointer to subscriber receiving message */
+            const void*                  msg    /**< Message struct passed to picoros_publish_msg(), read only */
+            );
+
+/**
+ * @brief Metadata of a received sample, read from its rmw attachment
+ */
+typedef struct {
+    int64_t  sequence_number;               /**< Publisher sequence number */
+    int64_t  source_timestamp;              /**< Publication time in nanoseconds since epoch */
+    uint8_t  publisher_gid[RMW_GID_SIZE];   /**< RMW GID of publisher */
+} picoros_sample_info_t;
+
+/** @brief Sub-bucket bits of latency histogram, relative bucket width is 2^-bits */
+#define PICOROS_LATENCY_SUB_BITS 3u
+/** @brief Number of latency histogram buckets, covering 0 to 2^32 us */
+#define PICOROS_LATENCY_BUCKETS ((32u - PICOROS_LATENCY_SUB_BITS + 1u) << PICOROS_LATENCY_SUB_BITS)
+
+/**
+ * @brief Fixed size end-to-end latency histogram
+ * @details Log-linear buckets in microseconds, values below 2^PICOROS_LATENCY_SUB_BITS us have
+ *          own bucket and each further power of two range is split in 2^PICOROS_LATENCY_SUB_BITS
+ *          buckets. Latency is receive time minus source timestamp of rmw attachment, so
+ *          clocks of publishing and subscribing hosts must be synchronized.
+ */
+typedef struct {
+    uint32_t counts[PICOROS_LATENCY_BUCKETS];   /**< Number of samples per bucket */
+    uint32_t total;                             /**< Number of recorded samples */
+    uint32_t skewed;                            /**< Samples with source timestamp in future, not recorded */
+    uint32_t min_us;                            /**< Minimum latency, valid if total is not 0 */
+    uint32_t max_us;                            /**< Maximum latency */
+    uint64_t sum_us;                            /**< Sum of latencies for mean */
+} picoros_latency_hist_t;
+
+/**
+ * @brief Borrowed view of a received payload
+ * @details Valid only during the callback it is passed to. If the payload is stored in
+ *          a single slice, data points directly to the transport buffer. Fragmented payloads
+ *          have data set to NULL and are read slice by slice with picoros_rx_view_next().
+ */
+typedef struct {
+    uint8_t*                 data;     /**< Contiguous payload (CDR encoded, read only), NULL if fragmented */
+    size_t                   len;      /**< Total payload size in bytes */
+    const picoros_sample_info_t* info; /**< Sample metadata, NULL if sample has no rmw attachment */
+    z_bytes_slice_iterator_t _it;      /**< Private slice iterator */
+} picoros_rx_view_t;
+
+/**
+ * @brief Callback function type for zero-copy subscriber data handling
+ */
+typedef void (*picoros_sub_view_cb_t)(
+            struct picoros_subscriber_s* sub,   /**< Pointer to subscriber receiving data */
+            picoros_rx_view_t*           view   /**< Borrowed payload view */
+            );
+
+/**
+ * @brief Callback function type for filtering received payloads
+ * @return True to deliver payload to subscriber, false to drop it
+ */
+typedef bool (*picoros_sub_filter_cb_t)(
+            struct picoros_subscriber_s* sub,   /**< Pointer to subscriber receiving data */
+            picoros_rx_view_t*           view   /**< Borrowed payload view */
+            );
+
+/** @brief Maximum number of subscribers dispatched by one executor */
+#define PICOROS_EXECUTOR_MAX_SUBS 32u
+
+/**
+ * @brief Handling of samples arriving to a full subscriber queue
+ */
+typedef enum {
+    PICOROS_QUEUE_DROP_NEWEST = 0,  /**< Count and drop arriving sample */
+    PICOROS_QUEUE_DROP_OLDEST,      /**< Count and drop oldest queued sample */
+} picoros_queue_policy_t;
+
+/**
+ * @brief Queued sample, contents are private
+ */
+typedef struct {
+    uint8_t* data;                  /**< Sample buffer from subscriber rx_pool or heap */
+    size_t   len;                   /**< Sample size */
+    picoros_sample_info_t info;     /**< Sample metadata */
+    bool     has_info;              /**< Sample had rmw attachment */
+} picoros_queue_entry_t;
+
+/**
+ * @brief Lock-free sample queue of a subscriber
+ * @details Filled by the session read task and drained by one executor worker at a time,
+ *          so callbacks of a subscriber never run concurrently and keep sample order.
+ */
+typedef struct {
+    picoros_queue_entry_t*  entries;    /**< Ring storage of depth entries */
+    uint32_t                depth;      /**< Queue depth, power of two */
+    picoros_queue_policy_t  policy;     /**< Policy when queue is full */
+    uint32_t                dropped;    /**< Number of samples dropped because queue was full or no buffer was free */
+    uint32_t                _head;      /**< Private producer index */
+    uint32_t                _tail;      /**< Private consumer index */
+    bool                    _busy;      /**< Private consumer claim */
+} picoros_sub_queue_t;
+
+/**
+ * @brief Pool of worker threads running subscriber callbacks
+ * @details Read task only copies samples to subscriber queues. Each worker serves its own share
+ *          of subscribers first and steals from the others when those are empty.
+ */
+typedef struct {
+    uint8_t                      n_workers;                         /**< Number of worker threads, up to PICOROS_MAX_WORKERS */
+    struct picoros_subscriber_s* _subs[PICOROS_EXECUTOR_MAX_SUBS];  /**< Private dispatched subscribers */
+    uint8_t                      _n_subs;                           /**< Private number of used _subs entries */
+    uint32_t                     _idle;                             /**< Private number of waiting workers */
+    uint8_t                      _started;                          /**< Private number of started workers */
+    bool                         _running;                          /**< Private run flag */
+    uint32_t                     _epochs[PICOROS_MAX_WORKERS + 1];  /**< Private run counters of workers and spin_once, odd while running */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_owned_mutex_t              _mutex;                            /**< Private idle lock */
+    z_owned_condvar_t            _cond;                             /**< Private work signal */
+    z_owned_task_t               _tasks[PICOROS_MAX_WORKERS];       /**< Private worker threads */
+#endif
+} picoros_executor_t;
+
+/** @brief Maximum number of slots in a subscriber mailbox */
+#define PICOROS_MAILBOX_MAX_SLOTS 4u
+
+/**
+ * @brief Keep-latest mailbox of a subscriber
+ * @details Each sample overwrites the oldest slot in place and no callback is called, newest
+ *          sample is read with picoros_take_latest(). More slots make it less likely that a
+ *          reader has to retry because the slot it reads is overwritten.
+ */
+typedef struct {
+    uint8_t*  mem;                                  /**< Slot memory of n_slots * buf_size bytes, allocated at declare if NULL */
+    size_t    buf_size;                             /**< Maximum sample size */
+    uint8_t   n_slots;                              /**< Number of slots, up to PICOROS_MAILBOX_MAX_SLOTS */
+    uint32_t  overwritten;                          /**< Number of samples overwritten before taken */
+    uint32_t  oversize;                             /**< Number of samples dropped for exceeding buf_size */
+    uint32_t  _seq[PICOROS_MAILBOX_MAX_SLOTS];      /**< Private slot sequence locks, odd while written */
+    size_t    _len[PICOROS_MAILBOX_MAX_SLOTS];      /**< Private slot sample sizes */
+    uint32_t  _written;                             /**< Private number of written samples */
+    uint32_t  _taken;                               /**< Private value of _written at last take */
+} picoros_mailbox_t;
+
+/**
+ * @brief Ingress rate limit of a subscriber
+ * @details Checked first on sample arrival, dropped samples are not copied or deserialized.
+ */
+typedef struct {
+    uint32_t  min_period_us;        /**< Drop samples arriving sooner than this after last accepted one, 0 for no limit */
+    uint32_t  every_nth;            /**< Accept only every Nth sample, 0 or 1 to accept all */
+    uint32_t  dropped;              /**< Number of dropped samples */
+    uint32_t  _count;               /**< Private number of arrived samples */
+    z_clock_t _last;                /**< Private arrival time of last accepted sample */
+    bool      _lock;                /**< Private lock of read task and local publishers */
+} picoros_throttle_t;
+
+/** @brief Maximum number of publishers tracked by a sequence tracker */
+#define PICOROS_SEQ_MAX_PUBLISHERS 8u
+
+/**
+ * @brief Sequence statistics of one publisher seen by a subscriber
+ * @details A skipped sequence number counts as lost until it arrives late, then it counts
+ *          as reordered. Late samples older than the 64 sample window cannot be checked for
+ *          duplicates and always count as reordered.
+ */
+typedef struct {
+    uint8_t   gid[RMW_GID_SIZE];    /**< RMW GID of publisher */
+    int64_t   last_seq;             /**< Highest received sequence number */
+    uint32_t  received;             /**< Number of received samples */
+    uint32_t  lost;                 /**< Number of sequence numbers not received */
+    uint32_t  duplicates;           /**< Number of samples received more than once */
+    uint32_t  reordered;            /**< Number of samples arriving after a higher sequence number */
+    uint64_t  _window;              /**< Private bitmap of received samples, bit n is last_seq - n */
+} picoros_seq_stats_t;
+
+/**
+ * @brief Per-publisher loss and reordering tracker of a subscriber
+ * @details Updated for every arriving sample before throttle and filter, publishers are
+ *          told apart by GID of rmw attachment.
  */
 typedef struct {
-    z_owned_subscriber_t zsub;         /**< Zenoh subscriber instance */
-    rmw_topic_t         topic;         /**< Topic information */
-    picoros_sub_cb_t    user_callback; /**< User callback for data handling */
+    picoros_seq_stats_t publishers[PICOROS_SEQ_MAX_PUBLISHERS];    /**< Statistics of first seen publishers */
+    uint32_t  untracked;            /**< Samples without rmw attachment or from publishers not fitting in table */
+    uint8_t   _count;               /**< Private number of used publishers entries */
+    bool      _lock;                /**< Private lock of read task and local publishers */
+} picoros_seq_tracker_t;
+
+/**
+ * @brief Topic of a wildcard subscription
+ * @details Created on first sample of a key expression, metadata is parsed from rmw key
+ *          expression once. Non rmw key expressions have name set to key expression and
+ *          no type or hash.
+ */
+typedef struct picoros_topic_entry_s {
+    char*       keyexpr;            /**< Key expression of topic, NULL if entry is free */
+    size_t      keyexpr_len;        /**< Length of key expression */
+    uint32_t    domain_id;          /**< ROS domain of topic */
+    rmw_topic_t topic;              /**< Topic name, type and RIHS hash */
+    void (*handler)(struct picoros_subscriber_s* sub, struct picoros_topic_entry_s* topic,
+                    picoros_rx_view_t* view);   /**< Topic handler, if NULL topic_callback of subscriber is used */
+    void*       user_data;          /**< User data, not used by picoros */
+    uint32_t    samples;            /**< Number of received samples */
+    uint32_t    _hash;              /**< Private key expression hash */
+} picoros_topic_entry_t;
+
+/**
+ * @brief Callback function type for wildcard subscription samples
+ */
+typedef void (*picoros_topic_cb_t)(
+            struct picoros_subscriber_s* sub,       /**< Pointer to subscriber receiving data */
+            picoros_topic_entry_t*       topic,     /**< Topic of sample */
+            picoros_rx_view_t*           view       /**< Borrowed payload view */
+            );
+
+/**
+ * @brief Hash map of wildcard subscription topics
+ * @details Filled from read task, entries are never removed while subscribed. Table is kept at
+ *          most three quarters full, samples of further topics are delivered without entry caching.
+ *          Entry key expressions are heap copies, freed by picoros_topic_map_clear().
+ */
+typedef struct {
+    picoros_topic_entry_t* entries; /**< Table of size zeroed entries */
+    uint16_t    size;               /**< Number of entries, power of two, at least 4 */
+    uint32_t    overflow;           /**< Number of samples of topics not fitting in table */
+    void (*new_topic_callback)(struct picoros_subscriber_s* sub,
+                               picoros_topic_entry_t* topic); /**< Called for new topic, can set its handler */
+    uint16_t    _count;             /**< Private number of used entries */
+} picoros_topic_map_t;
+
+/**
+ * @brief Subscriber structure for Pico-ROS
+ * @details Subscribers of the same key expression in a process share one zenoh subscriber
+ *          and liveliness token, samples are fanned out to each of them.
+ */
+typedef struct picoros_subscriber_s {
+    z_owned_subscriber_t  zsub;          /**< Zenoh subscriber instance */
+    rmw_topic_t           topic;         /**< Topic information */
+    picoros_sub_cb_t      user_callback; /**< User callback for data handling, receives a read only copy of payload shared by subscribers of topic */
+    picoros_sub_view_cb_t view_callback; /**< Zero-copy callback, used instead of user_callback if set */
+    void*                 user_data;     /**< User data, not used by picoros */
+    picoros_pool_t*       rx_pool;       /**< Receive buffer pool for user_callback, if NULL heap is used */
+    picoros_executor_t*   executor;      /**< Executor running callbacks from queue, if NULL callbacks run on read task */
+    picoros_sub_queue_t*  queue;         /**< Sample queue, required with executor */
+    picoros_mailbox_t*    mailbox;       /**< Keep-latest mailbox, if set samples are only stored for picoros_take_latest() */
+    picoros_throttle_t*   throttle;      /**< Ingress rate limit, if NULL all samples are accepted */
+    picoros_qos_t         qos;           /**< QoS profile advertised to publishers, transient local queries cached publications */
+    picoros_sub_filter_cb_t filter;      /**< Payload filter, if NULL all payloads are delivered */
+    picoros_topic_map_t*  topic_map;     /**< Topic map of wildcard subscription, if set samples go to topic handlers */
+    picoros_topic_cb_t    topic_callback; /**< Default topic handler of wildcard subscription */
+    picoros_latency_hist_t* latency;     /**< End-to-end latency histogram, if set updated for each accepted sample */
+    picoros_seq_tracker_t* seq_tracker;  /**< Loss and reordering tracker, if set updated for each arriving sample */
+    picoros_stats_t*      stats;         /**< Runtime counters, if NULL not collected */
+    bool                  intra_process; /**< Receive directly from intra_process publishers of same topic in this process */
+    picoros_sub_msg_cb_t  msg_callback;  /**< Receives message structs of local picoros_publish_msg(), runs on publishing thread */
+    struct picoros_intra_topic_s* _intra;      /**< Private intra-process registry topic */
+    struct picoros_subscriber_s*  _intra_next; /**< Private next subscriber of registry topic */
+    bool                  _rx_lock;      /**< Private lock serializing local publishers and read task on queue or mailbox */
+    struct picoros_intra_topic_s* _shared;      /**< Private registry topic of shared zenoh subscriber */
+    struct picoros_subscriber_s*  _shared_next; /**< Private next subscriber sharing zenoh subscriber */
+    z_owned_liveliness_token_t    _token;       /**< Private liveliness token of own zenoh subscriber, declared for typed topics */
 } picoros_subscriber_t;
 
 /** @} */
@@ -211,6 +777,7 @@ typedef struct {
     const char* name;                  /**< Node name */
     uint32_t    domain_id;             /**< ROS domain ID */
     uint8_t     guid[RMW_GID_SIZE];    /**< Node GUID */
+    picoros_session_t* session;        /**< Session of node and its entities, if NULL default session is used */
 } picoros_node_t;
 
 /** @} */
@@ -227,6 +794,10 @@ typedef struct {
 typedef struct {
     char* mode;                     /**< Connection mode (peer/client) */
     char* locator;                  /**< Network locator string */
+    picoros_session_t* session;     /**< Session to open, if NULL default session is used */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_task_attr_t* read_task_attr;  /**< Read task attributes (priority, affinity), if NULL defaults are used */
+#endif
 } picoros_interface_t;
 
 /** @} */
@@ -238,10 +809,19 @@ typedef enum {
     PICOROS_OK = 0,                /**< Operation successful */
     PICOROS_ERROR = -1,            /**< Operation failed */
     PICOROS_NOT_READY = -2,        /**< System not ready */
+    PICOROS_TIMEOUT = -3,          /**< Operation timed out */
 } picoros_res_t;
 
 /* Exported functions --------------------------------------------------------*/
 
+/**
+ * @brief Initialize buffer pool, allocates pool memory if not given
+ * @param pool Pointer to pool with buf_size and buf_count set
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup pool
+ */
+picoros_res_t picoros_pool_init(picoros_pool_t* pool);
+
 /**
  * @brief Initialize the network interface
  * @param ifx Pointer to interface configuration
@@ -251,11 +831,115 @@ typedef enum {
 picoros_res_t picoros_interface_init(picoros_interface_t* ifx);
 
 /**
- * @brief Shutdown the network interface
+ * @brief Shutdown the network interface, closes default session
  * @ingroup interface
  */
 void picoros_interface_shutdown(void);
 
+/**
+ * @brief Same as picoros_interface_shutdown(), kept for compatibility
+ * @ingroup interface
+ */
+void zenoh_shutdown(void);
+
+/**
+ * @brief Close a session opened with picoros_interface_init()
+ * @param session Session to close, NULL for default session
+ * @ingroup session
+ */
+void picoros_session_shutdown(picoros_session_t* session);
+
+/**
+ * @brief Open one session per shard
+ * @param shard Pointer to shard set with sessions array and n_shards set
+ * @param ifx Interface configuration used for every shard, its session field is ignored
+ * @return PICOROS_OK on success, PICOROS_NOT_READY if router is not available, error code otherwise
+ * @ingroup session
+ */
+picoros_res_t picoros_shard_init(picoros_shard_t* shard, picoros_interface_t* ifx);
+
+/**
+ * @brief Select shard session for a topic by hashing its name
+ * @details Default mapping for topics without explicit placement, same name always maps
+ *          to the same shard.
+ * @param shard Pointer to initialized shard set
+ * @param topic_name Topic name
+ * @return Pointer to shard session
+ * @ingroup session
+ */
+picoros_session_t* picoros_shard_select(picoros_shard_t* shard, const char* topic_name);
+
+/**
+ * @brief Close all shard sessions
+ * @param shard Pointer to initialized shard set
+ * @ingroup session
+ */
+void picoros_shard_shutdown(picoros_shard_t* shard);
+
+/**
+ * @brief Start collecting publications of default session to a transport batch
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup batching
+ */
+picoros_res_t picoros_batch_begin(void);
+
+/**
+ * @brief Send collected publications of default session
+ * @details Ends batching started with picoros_batch_begin(). With automatic batching
+ *          enabled the pending batch is sent and automatic batching continues.
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup batching
+ */
+picoros_res_t picoros_batch_flush(void);
+
+/**
+ * @brief Enable or disable automatic batching of default session
+ * @details Size limit is checked on every publish. Latency limit is checked on publish,
+ *          on picoros_batch_poll() and by a flush task in multi-threaded builds.
+ * @param cfg Pointer to batching limits, NULL to disable automatic batching
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup batching
+ */
+picoros_res_t picoros_batch_auto(const picoros_batch_cfg_t* cfg);
+
+/**
+ * @brief Flush automatic batch of default session if latency limit is reached
+ * @ingroup batching
+ */
+void picoros_batch_poll(void);
+
+/**
+ * @brief Start collecting publications of a session to a transport batch
+ * @param session Session to batch, NULL for default session
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup batching
+ */
+picoros_res_t picoros_session_batch_begin(picoros_session_t* session);
+
+/**
+ * @brief Send collected publications of a session, see picoros_batch_flush()
+ * @param session Session to flush, NULL for default session
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup batching
+ */
+picoros_res_t picoros_session_batch_flush(picoros_session_t* session);
+
+/**
+ * @brief Enable or disable automatic batching of a session, see picoros_batch_auto()
+ * @param session Session to batch, NULL for default session
+ * @param cfg Pointer to batching limits, NULL to disable automatic batching
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup batching
+ */
+picoros_res_t picoros_session_batch_auto(picoros_session_t* session, const picoros_batch_cfg_t* cfg);
+
+/**
+ * @brief Flush automatic batch of a session if latency limit is reached
+ * @param session Session to check, NULL for default session
+ * @ingroup batching
+ */
+void picoros_session_batch_poll(picoros_session_t* session);
+
 /**
  * @brief Initialize a ROS node
  * @param node Pointer to node configuration
@@ -273,6 +957,17 @@ picoros_res_t picoros_node_init(picoros_node_t* node);
  */
 picoros_res_t picoros_publisher_declare(picoros_node_t* node, picoros_publisher_t *pub);
 
+/**
+ * @brief Undeclare a publisher
+ * @details Removes it from intra-process registry, its registry topic is freed once nothing else
+ *          uses it. Waits for deliveries on other threads reading the publisher, can be called from
+ *          a subscriber callback. Publication cache memory stays with the user.
+ * @param pub Pointer to declared publisher
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup publisher
+ */
+picoros_res_t picoros_publisher_undeclare(picoros_publisher_t *pub);
+
 /**
  * @brief Publish data on a topic
  * @param pub Pointer to publisher instance
@@ -283,10 +978,82 @@ picoros_res_t picoros_publisher_declare(picoros_node_t* node, picoros_publisher_
  */
 picoros_res_t picoros_publish(picoros_publisher_t *pub, uint8_t *payload, size_t len);
 
+/**
+ * @brief Check if any subscriber matches publisher
+ * @details Always true if zenoh-pico is built without matching support.
+ * @param pub Pointer to publisher instance
+ * @return True if at least one subscriber matches
+ * @ingroup publisher
+ */
+bool picoros_publisher_has_subscribers(picoros_publisher_t *pub);
+
+/**
+ * @brief Serialize and publish a message only if any subscriber matches
+ * @details Without matching subscribers serializer is not called and nothing is sent, unless
+ *          publisher has transient local durability and caches the message for late joiners.
+ *          Buffer is loaned as with picoros_publisher_loan().
+ * @param pub Pointer to publisher instance
+ * @param max_size Maximum size of serialized message
+ * @param serialize Callback serializing message into loaned buffer
+ * @param ctx User context passed to serialize
+ * @return PICOROS_OK if published or skipped, error code otherwise
+ * @ingroup publisher
+ */
+picoros_res_t picoros_publish_serialized(picoros_publisher_t *pub, size_t max_size,
+                                         picoros_serialize_cb_t serialize, void* ctx);
+
+/**
+ * @brief Publish a message struct
+ * @details Local intra_process subscribers with msg_callback get msg pointer without
+ *          serialization. Message is serialized with picoros_publish_serialized() only if
+ *          remote subscribers, transient local cache or local subscribers without msg_callback
+ *          need payload.
+ * @param pub Pointer to publisher instance
+ * @param msg Message struct, passed as ctx to serialize
+ * @param max_size Maximum size of serialized message
+ * @param serialize Callback serializing msg into loaned buffer
+ * @return PICOROS_OK if published or skipped, error code otherwise
+ * @ingroup publisher
+ */
+picoros_res_t picoros_publish_msg(picoros_publisher_t *pub, const void* msg, size_t max_size,
+                                  picoros_serialize_cb_t serialize);
+
+/**
+ * @brief Loan a buffer for serializing a message to be published
+ * @details Buffer is taken from publisher tx_pool or heap. Ownership is given back with
+ *          picoros_publish_loaned() or picoros_publisher_loan_return().
+ * @param pub Pointer to publisher instance
+ * @param size Required buffer size in bytes
+ * @return Pointer to buffer, NULL if no buffer is available
+ * @ingroup publisher
+ */
+uint8_t* picoros_publisher_loan(picoros_publisher_t *pub, size_t size);
+
+/**
+ * @brief Publish loaned buffer, transport takes ownership of the buffer without copying it
+ * @param pub Pointer to publisher instance that loaned the buffer
+ * @param buf Buffer returned by picoros_publisher_loan()
+ * @param len Length of data in bytes
+ * @return PICOROS_OK on success, error code otherwise. Buffer is released in both cases.
+ * @ingroup publisher
+ */
+picoros_res_t picoros_publish_loaned(picoros_publisher_t *pub, uint8_t *buf, size_t len);
+
+/**
+ * @brief Return unused loaned buffer
+ * @param pub Pointer to publisher instance that loaned the buffer
+ * @param buf Buffer returned by picoros_publisher_loan()
+ * @ingroup publisher
+ */
+void picoros_publisher_loan_return(picoros_publisher_t *pub, uint8_t *buf);
+
 /**
  * @brief Declare a subscriber for a node
+ * @details With executor set, samples are copied to the subscriber queue and callbacks run on
+ *          executor workers. View callback then receives a contiguous view of the queued copy.
+ *          Subscribers of the same key expression on the same session share one zenoh subscriber.
  * @param node Pointer to node instance
- * @param sub Pointer to subscriber configuration
+ * @param sub Pointer to subscriber configuration. Should be in scope while subscribed.
  * @return PICOROS_OK on success, error code otherwise
  * @ingroup subscriber
  */
@@ -294,12 +1061,108 @@ picoros_res_t picoros_subscriber_declare(picoros_node_t* node, picoros_subscribe
 
 /**
  * @brief Unsubscribe from a topic
+ * @details Waits until deliveries to the subscriber running on other threads are done. Can be
+ *          called from the subscriber's own callbacks, network or intra-process, the subscriber
+ *          must then stay valid until that callback returns. Callbacks on two threads must not
+ *          unsubscribe from the same topic at once.
  * @param sub Pointer to subscriber instance
  * @return PICOROS_OK on success, error code otherwise
  * @ingroup subscriber
  */
 picoros_res_t picoros_unsubscribe(picoros_subscriber_t *sub);
 
+/**
+ * @brief Free key expressions of topic map entries and empty the map
+ * @details Call after picoros_unsubscribe() of the wildcard subscription, topic pointers given
+ *          to callbacks are invalid afterwards.
+ * @param map Pointer to topic map
+ * @ingroup subscriber
+ */
+void picoros_topic_map_clear(picoros_topic_map_t* map);
+
+/**
+ * @brief Copy sequence statistics of publishers seen by subscriber
+ * @param sub Pointer to subscriber with seq_tracker
+ * @param stats Array receiving statistics
+ * @param max Size of stats array
+ * @return Number of publishers copied
+ * @ingroup subscriber
+ */
+uint8_t picoros_seq_stats(picoros_subscriber_t* sub, picoros_seq_stats_t* stats, uint8_t max);
+
+/**
+ * @brief Clear sequence statistics and forget tracked publishers
+ * @param sub Pointer to subscriber with seq_tracker
+ * @ingroup subscriber
+ */
+void picoros_seq_stats_reset(picoros_subscriber_t* sub);
+
+/**
+ * @brief Copy newest sample from subscriber mailbox
+ * @param sub Pointer to subscriber with mailbox
+ * @param buf Buffer for sample data (CDR encoded)
+ * @param size Size of buf
+ * @param len Set to sample size
+ * @return PICOROS_OK if a sample newer than last taken one was copied, PICOROS_NOT_READY if there is
+ *         no new sample, error code otherwise
+ * @ingroup subscriber
+ */
+picoros_res_t picoros_take_latest(picoros_subscriber_t* sub, uint8_t* buf, size_t size, size_t* len);
+
+/**
+ * @brief Start executor worker threads
+ * @param executor Pointer to executor with n_workers set
+ * @return PICOROS_OK on success, error code otherwise. Always fails in single-threaded builds.
+ * @ingroup subscriber
+ */
+picoros_res_t picoros_executor_start(picoros_executor_t* executor);
+
+/**
+ * @brief Stop executor worker threads, queued samples stay queued
+ * @param executor Pointer to started executor
+ * @ingroup subscriber
+ */
+void picoros_executor_stop(picoros_executor_t* executor);
+
+/**
+ * @brief Run queued callbacks on calling thread
+ * @details For single-threaded builds or executors without workers.
+ * @param executor Pointer to executor
+ * @return Number of callbacks run
+ * @ingroup subscriber
+ */
+uint32_t picoros_executor_spin_once(picoros_executor_t* executor);
+
+/**
+ * @brief Get next slice of a borrowed payload view.
+ * @details Signature matches ps_slice_next_t so it can be given directly to ps_reader_init()
+ *          for deserializing fragmented payloads without copying them.
+ * @param view Pointer to picoros_rx_view_t passed to view callback
+ * @param data Set to start of next slice
+ * @param len Set to size of next slice
+ * @return true if slice was returned, false if there are no more slices
+ * @ingroup subscriber
+ */
+bool picoros_rx_view_next(void* view, const uint8_t** data, size_t* len);
+
+/**
+ * @brief Record a latency sample in histogram
+ * @details Safe to call concurrently with other recorders.
+ * @param hist Pointer to latency histogram
+ * @param latency_us Latency in microseconds
+ * @ingroup subscriber
+ */
+void picoros_latency_record(picoros_latency_hist_t* hist, uint32_t latency_us);
+
+/**
+ * @brief Get latency percentile from histogram
+ * @param hist Pointer to latency histogram
+ * @param percentile Percentile from 0 to 100
+ * @return Upper bound of bucket holding percentile in microseconds, 0 if histogram is empty
+ * @ingroup subscriber
+ */
+uint32_t picoros_latency_percentile(const picoros_latency_hist_t* hist, double percentile);
+
 /**
  * @brief Declare a service server for a node
  * @param node Pointer to node instance
@@ -310,8 +1173,36 @@ picoros_res_t picoros_unsubscribe(picoros_subscriber_t *sub);
 picoros_res_t picoros_service_declare(picoros_node_t* node, picoros_srv_server_t* srv);
 
 
+/**
+ * @brief Send reply of a deferred service request and release its handle
+ * @param request Request handle passed to deferred_callback
+ * @param data Pointer to reply data (CDR encoded)
+ * @param len Size of reply data
+ * @return PICOROS_OK on success, error code otherwise. Handle is released in both cases.
+ * @ingroup service_server
+ */
+picoros_res_t picoros_service_reply(picoros_srv_request_t* request, uint8_t* data, size_t len);
+
+/**
+ * @brief Start worker pool threads
+ * @param workers Pointer to worker pool with n_workers set
+ * @return PICOROS_OK on success, error code otherwise. Always fails in single-threaded builds.
+ * @ingroup service_server
+ */
+picoros_res_t picoros_workers_start(picoros_workers_t* workers);
+
+/**
+ * @brief Stop worker pool threads after queued requests are processed
+ * @param workers Pointer to started worker pool
+ * @ingroup service_server
+ */
+void picoros_workers_stop(picoros_workers_t* workers);
+
 /**
  * @brief Initialize service client with precomputed key expression.
+ * @details Unless use_get is set, a querier is declared once so calls don't resolve routing
+ *          and build options again. Falls back to z_get calls if querier can't be declared.
+ *          Session must be open before init.
  * @param client Pointer to client instance.
  * @return PICOROS_OK on success, error code otherwise
  * @ingroup service_client
@@ -324,15 +1215,49 @@ picoros_res_t picoros_service_client_init(picoros_srv_client_t * client);
  * @param client Pointer to client instance. Should be in scope until service call is ongoing.
  * @param payload Pointer to data payload
  * @param len Size of data
- * @return PICOROS_OK on success, PICOROS_NOT_READY when request already progress, error code otherwise
+ * @return PICOROS_OK on success, PICOROS_NOT_READY when all request slots are in progress, error code otherwise
  * @ingroup service_client
  */
 picoros_res_t picoros_service_call(picoros_srv_client_t* client, uint8_t* payload, size_t len);
 
+/**
+ * @brief Call service and get sequence number of the request.
+ * @details Reply and drop callbacks of the request are called with client->reply_seq set to
+ *          this sequence number, so replies of pipelined requests can be told apart.
+ * @param client Pointer to client instance. Should be in scope until service call is ongoing.
+ * @param payload Pointer to data payload
+ * @param len Size of data
+ * @param seq Set to sequence number of the request, can be NULL
+ * @return PICOROS_OK on success, PICOROS_NOT_READY when all request slots are in progress, error code otherwise
+ * @ingroup service_client
+ */
+picoros_res_t picoros_service_call_seq(picoros_srv_client_t* client, uint8_t* payload, size_t len, int64_t* seq);
+
+/**
+ * @brief Call service and wait for the reply.
+ * @details Caller is blocked on a condition variable until the reply arrives, the request is dropped
+ *          or timeout expires. Single-threaded builds read the session while waiting.
+ *          User and drop callbacks are not called for synchronous calls.
+ * @param client Pointer to client instance.
+ * @param payload Pointer to request data
+ * @param len Size of request data
+ * @param reply_buf Buffer for reply data (CDR encoded)
+ * @param reply_len In: size of reply_buf. Out: size of received reply, 0 if none.
+ * @param timeout_ms Maximum time to wait for reply. Calls up to querier timeout go through the querier and
+ *                   stop waiting at timeout_ms, longer ones are sent with z_get using timeout_ms as
+ *                   request timeout. Slot is free for the next call as soon as the reply arrives or
+ *                   the call times out, late replies are discarded.
+ * @return PICOROS_OK on reply, PICOROS_TIMEOUT if no reply arrived, PICOROS_NOT_READY when all request
+ *         slots are in progress, PICOROS_ERROR on error reply, on reply not fitting reply_buf or other failure.
+ * @ingroup service_client
+ */
+picoros_res_t picoros_service_call_sync(picoros_srv_client_t* client, uint8_t* payload, size_t len,
+                                        uint8_t* reply_buf, size_t* reply_len, uint32_t timeout_ms);
+
 /**
  * @brief Check if client has ongoing service call.
  * @param client Pointer to client instance.
- * @return true if request is in progress
+ * @return true if any request is in progress
  * @ingroup service_client
  */
 bool picoros_service_call_in_progress(picoros_srv_client_t* client);
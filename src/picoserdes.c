@@ -34,6 +34,105 @@ SRV_LIST(TYPE_HASH, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+// Point reader to current CDR buffer position. Value crossing the end of slice is
+// stitched together in seam buffer if stitch is set.
+static bool ps_reader_seek(ps_reader_t* r, bool stitch){
+    ucdrBuffer* ub = &r->ub;
+    size_t pos = ub->offset + sizeof(uint32_t); // offset 0 is after encapsulation header
+    if (pos < r->slice_pos){
+        return false; // reader can only move forward
+    }
+
+    // find slice containing current position
+    while (pos >= r->slice_pos + r->slice_len){
+        r->slice_pos += r->slice_len;
+        if (!r->next(r->ctx, &r->slice, &r->slice_len)){
+            r->slice_len = 0;
+            return false;
+        }
+    }
+    size_t start = pos - r->slice_pos;
+    size_t avail = r->slice_len - start;
+    if (!stitch || avail >= PS_READER_MAX_PRIMITIVE){
+        ub->init = (uint8_t*)r->slice + start;
+        ub->iterator = ub->init;
+        ub->final = ub->init + avail;
+        return true;
+    }
+
+    // copy tail of this slice and start of following ones to seam
+    size_t n = 0;
+    memset(r->seam, 0, sizeof(r->seam));
+    memcpy(r->seam, r->slice + start, avail);
+    n += avail;
+    while (n < PS_READER_MAX_PRIMITIVE){
+        const uint8_t* data;
+        size_t len;
+        if (!r->next(r->ctx, &data, &len)){
+            break;
+        }
+        r->slice_pos += r->slice_len;
+        r->slice = data;
+        r->slice_len = len;
+        size_t take = (len < sizeof(r->seam) - n) ? len : sizeof(r->seam) - n;
+        memcpy(&r->seam[n], data, take);
+        n += take;
+    }
+    r->stitched += n;
+    ub->init = r->seam;
+    ub->iterator = r->seam;
+    ub->final = r->seam + n;
+    return true;
+}
+
+// Copy string of len bytes at current position to string buffer. Bytes are taken from current
+// window, seam or slice, and then from following slices, reader is left after the string.
+static bool ps_reader_stitch_string(ps_reader_t* r, uint32_t len, char** pstring){
+    ucdrBuffer* ub = &r->ub;
+    if (len > sizeof(r->strings) - r->strings_used){
+        return false;
+    }
+    char* dst = &r->strings[r->strings_used];
+    size_t avail = (size_t)(ub->final - ub->iterator);
+    size_t n = (avail < len) ? avail : len;
+    memcpy(dst, ub->iterator, n);
+    ub->iterator += n;
+    size_t pos = ub->offset + sizeof(uint32_t) + n;
+    bool from_slices = n < len;
+    while (n < len){
+        if (pos >= r->slice_pos + r->slice_len){
+            r->slice_pos += r->slice_len;
+            if (!r->next(r->ctx, &r->slice, &r->slice_len)){
+                r->slice_len = 0;
+                return false;
+            }
+            continue;
+        }
+        size_t start = pos - r->slice_pos;
+        size_t take = r->slice_len - start;
+        take = (take < len - n) ? take : len - n;
+        memcpy(&dst[n], r->slice + start, take);
+        n += take;
+        pos += take;
+    }
+    if (from_slices){
+        ub->init = (uint8_t*)r->slice + (pos - r->slice_pos);
+        ub->iterator = ub->init;
+        ub->final = (uint8_t*)r->slice + r->slice_len;
+    }
+    r->strings_used += len;
+    r->stitched += len;
+    ub->offset += len;
+    ub->last_data_size = 1;
+    *pstring = dst;
+    return true;
+}
+
+// Called by ucdr when value does not fit in current window, returns true on error
+static bool ps_reader_on_full(ucdrBuffer* ub, void* args){
+    return !ps_reader_seek((ps_reader_t*)args, true);
+}
+
 // Base types serialization / deserialization wrappers
 #define PS_SER_BASE(TYPE)                                                              \
 bool ps_ser_##TYPE(ucdrBuffer* writer, TYPE* msg) {                                    \
@@ -68,6 +167,19 @@ BASE_TYPES_LIST(PS_DES_BASE)
 bool ucdr_deserialize_rstring(ucdrBuffer* ub, char** pstring){
     uint32_t len = 0;
     bool ret = ucdr_deserialize_endian_uint32_t(ub, ub->endianness, &len);
+    if (ret && ub->on_full_buffer == ps_reader_on_full){
+        // string is read from slice memory, if it is in seam buffer or crosses slices it is copied
+        ps_reader_t* r = (ps_reader_t*)ub->args;
+        bool in_seam = ub->iterator >= r->seam && ub->iterator <= r->seam + sizeof(r->seam);
+        if (in_seam && ub->offset + sizeof(uint32_t) >= r->slice_pos && ps_reader_seek(r, false)){
+            in_seam = false;
+        }
+        if (in_seam || len > (size_t)(ub->final - ub->iterator)){
+            ret = ps_reader_stitch_string(r, len, pstring);
+            ub->error = ub->error || !ret;
+            return ret;
+        }
+    }
     if (ret){
         *pstring = (char*)ub->iterator;
         ub->iterator += len;
@@ -121,6 +233,17 @@ bool ucdr_serialize_sequence_rstring(ucdrBuffer* ub, char** strings, uint32_t nu
     return ucdr_serialize_array_rstring(ub, strings, number);
 }
 
+// Init reader for fragmented cdr buffer
+bool ps_reader_init(ps_reader_t* reader, ps_slice_next_t next, void* ctx){
+    memset(reader, 0, sizeof(ps_reader_t));
+    reader->next = next;
+    reader->ctx = ctx;
+    ucdr_init_buffer(&reader->ub, reader->seam, 0);
+    ucdr_set_on_full_buffer_callback(&reader->ub, ps_reader_on_full, reader);
+    // position reader after encapsulation header
+    return ps_reader_seek(reader, true);
+}
+
 // Start cdr sequence and return writer object
 ucdr_writer_t ucdr_seq_start(ucdrBuffer* ub){
     // Write sequence size and save pointer for later access
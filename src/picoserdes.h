@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "ucdr/microcdr.h"
+#include "picotrace.h"
  /**
  * @defgroup user_types_list User types list
  * @ingroup picoserdes
@@ -192,6 +193,43 @@ typedef struct {
     size_t      len;       /**< Current length */
 } ucdr_writer_t;
 
+/** @brief Largest primitive CDR type size */
+#define PS_READER_MAX_PRIMITIVE 8u
+/** @brief Size of buffer holding values that cross slice boundaries */
+#define PS_READER_SEAM_SIZE (2u * PS_READER_MAX_PRIMITIVE)
+#ifndef PS_READER_STRING_SIZE
+/** @brief Size of buffer holding strings that cross slice boundaries */
+#define PS_READER_STRING_SIZE 512u
+#endif
+
+/**
+ * @brief Function returning next slice of a fragmented CDR buffer
+ * @param ctx Slice iterator context
+ * @param data Set to start of next slice
+ * @param len Set to size of next slice
+ * @return true if slice was returned, false if there are no more slices
+ */
+typedef bool (*ps_slice_next_t)(void* ctx, const uint8_t** data, size_t* len);
+
+/**
+ * @brief Reader context for deserializing fragmented CDR buffers in place
+ * @details Reads directly from the slices. Only primitive values crossing a slice boundary
+ *          are stitched together in a small seam buffer, strings crossing one are copied
+ *          to the string buffer.
+ */
+typedef struct {
+    ucdrBuffer      ub;                         /**< CDR buffer used by deserialization functions */
+    ps_slice_next_t next;                       /**< Slice iterator */
+    void*           ctx;                        /**< Slice iterator context */
+    const uint8_t*  slice;                      /**< Current slice */
+    size_t          slice_len;                  /**< Current slice size */
+    size_t          slice_pos;                  /**< Position of current slice in CDR buffer */
+    size_t          stitched;                   /**< Number of bytes copied to seam buffer */
+    uint8_t         seam[PS_READER_SEAM_SIZE];  /**< Seam buffer */
+    size_t          strings_used;               /**< Number of bytes used in string buffer */
+    char            strings[PS_READER_STRING_SIZE]; /**< String buffer */
+} ps_reader_t;
+
 /* Exported constants --------------------------------------------------------*/
 /**
  * @defgroup type_constats Type name and hash constants
@@ -321,6 +359,7 @@ BASE_TYPES_LIST(PS_DES_FUNC_DEF)
 #define _ps_serialize(pBUF, pMSG, MAX)                                                              \
     ({                                                                                              \
         ucdrBuffer writer = {};                                                                     \
+        PICOTRACE_BEGIN(PICOTRACE_EV_SERIALIZE, MAX);                                               \
         *((uint32_t*)pBUF) =  0x0100; /*Little endian header*/                                      \
         ucdr_init_buffer(&writer, pBUF + sizeof(uint32_t), MAX - sizeof(uint32_t));                 \
         _Generic((pMSG),                                                                            \
@@ -330,6 +369,7 @@ BASE_TYPES_LIST(PS_DES_FUNC_DEF)
             default: 0                                                                              \
         )(&writer, pMSG);                                                                           \
         size_t _ret = ucdr_buffer_length(&writer) + sizeof(uint32_t);                               \
+        PICOTRACE_END(PICOTRACE_EV_SERIALIZE, _ret);                                                \
         _ret;                                                                                       \
     })
 /**
@@ -343,6 +383,7 @@ BASE_TYPES_LIST(PS_DES_FUNC_DEF)
 #define _ps_deserialize(pBUF, pMSG, MAX)                                                            \
     ({                                                                                              \
         ucdrBuffer reader = {};                                                                     \
+        PICOTRACE_BEGIN(PICOTRACE_EV_DESERIALIZE, MAX);                                             \
         ucdr_init_buffer(&reader, pBUF + sizeof(uint32_t), MAX - sizeof(uint32_t));                 \
         bool _ok = _Generic((pMSG),                                                                 \
             PS_DEFER(BASE_TYPES_LIST_INDIRECT)(PS_SEL_DES)                                          \
@@ -350,9 +391,50 @@ BASE_TYPES_LIST(PS_DES_FUNC_DEF)
             PS_DEFER(SRV_LIST_INDIRECT)(PS_SEL_SRV_DES, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED) \
             default: 0                                                                              \
         )(&reader, pMSG);                                                                           \
+        PICOTRACE_END(PICOTRACE_EV_DESERIALIZE, _ok);                                               \
+        _ok;                                                                                        \
+    })
+
+/**
+ * @brief Generic deserialization macro for fragmented buffers
+ * @param pREADER Pointer to reader initialized with ps_reader_init()
+ * @param pMSG Pointer to ROS message
+ * @return true if deserialization successful
+ */
+#define ps_deserialize_reader(pREADER, pMSG) PS_EXPAND(_ps_deserialize_reader(pREADER, pMSG))
+#define _ps_deserialize_reader(pREADER, pMSG)                                                       \
+    ({                                                                                              \
+        PICOTRACE_BEGIN(PICOTRACE_EV_DESERIALIZE, 0);                                               \
+        bool _ok = _Generic((pMSG),                                                                 \
+            PS_DEFER(BASE_TYPES_LIST_INDIRECT)(PS_SEL_DES)                                          \
+            PS_DEFER(MSG_LIST_INDIRECT)(PS_UNUSED, PS_SEL_DES, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)     \
+            PS_DEFER(SRV_LIST_INDIRECT)(PS_SEL_SRV_DES, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED) \
+            default: 0                                                                              \
+        )(&(pREADER)->ub, pMSG);                                                                    \
+        _ok = _ok && !(pREADER)->ub.error;                                                          \
+        PICOTRACE_END(PICOTRACE_EV_DESERIALIZE, _ok);                                               \
         _ok;                                                                                        \
     })
 
+/** @} */
+
+ /**
+ * @defgroup ps_reader Fragmented buffer reader
+ * @ingroup picoserdes
+ * @{
+ */
+/**
+ * @brief Initialize reader for fragmented CDR buffer and skip encapsulation header
+ * @param reader Reader context
+ * @param next Function returning slices of the buffer in order
+ * @param ctx Context given to next function
+ * @return true if buffer contains CDR header
+ * @note Strings are returned as pointers to slice memory, strings crossing a slice boundary
+ *       point to the string buffer of reader, so reader must be kept while they are used.
+ *       Deserialization fails if they don't fit PS_READER_STRING_SIZE. Slices except the
+ *       last one must be at least PS_READER_SEAM_SIZE bytes.
+ */
+bool ps_reader_init(ps_reader_t* reader, ps_slice_next_t next, void* ctx);
 /** @} */
 
  /**
@@ -446,6 +528,7 @@ void ucdr_seq_end(ucdr_writer_t* writer);
 
 #undef ps_deserialize
 #undef ps_serialize
+#undef ps_deserialize_reader
 
 /**
  * @defgroup generic_serdes_macros Generic serdes c++ overrides
@@ -472,12 +555,19 @@ void ucdr_seq_end(ucdr_writer_t* writer);
         return ps_des_##TYPE(&reader, pMSG);                               \
     }
 
+#define PS_CPP_DES_READER_OVERLOAD(TYPE, ...)                              \
+    inline bool ps_deserialize_reader(ps_reader_t* pREADER, TYPE* pMSG) {  \
+        return ps_des_##TYPE(&pREADER->ub, pMSG) && !pREADER->ub.error;    \
+    }
+
 
 // Generate C++ overloads for all message types
 BASE_TYPES_LIST(PS_CPP_SER_OVERLOAD)
 BASE_TYPES_LIST(PS_CPP_DES_OVERLOAD)
+BASE_TYPES_LIST(PS_CPP_DES_READER_OVERLOAD)
 MSG_LIST(PS_UNUSED, PS_CPP_SER_OVERLOAD, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
 MSG_LIST(PS_UNUSED, PS_CPP_DES_OVERLOAD, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+MSG_LIST(PS_UNUSED, PS_CPP_DES_READER_OVERLOAD, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
 
 // Generate C++ overloads for service request/reply types
 #define PS_CPP_SRV_SER_OVERLOAD(TYPE, NAME, HASH, ...)                     \
@@ -510,6 +600,12 @@ MSG_LIST(PS_UNUSED, PS_CPP_DES_OVERLOAD, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNU
         ucdr_init_buffer(&reader, pBUF + sizeof(uint32_t),                  \
                         MAX - sizeof(uint32_t));                            \
         return ps_des_##TYPE##_reply(&reader, pMSG);                        \
+    }                                                                       \
+    inline bool ps_deserialize_reader(ps_reader_t* pREADER, request_##TYPE* pMSG) { \
+        return ps_des_##TYPE##_request(&pREADER->ub, pMSG) && !pREADER->ub.error; \
+    }                                                                       \
+    inline bool ps_deserialize_reader(ps_reader_t* pREADER, reply_##TYPE* pMSG) { \
+        return ps_des_##TYPE##_reply(&pREADER->ub, pMSG) && !pREADER->ub.error; \
     }
 
 // Generate C++ overloads for all service types
@@ -521,6 +617,7 @@ SRV_LIST(PS_CPP_SRV_DES_OVERLOAD, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS
 // Clean up the template macros
 #undef PS_CPP_SER_OVERLOAD
 #undef PS_CPP_DES_OVERLOAD
+#undef PS_CPP_DES_READER_OVERLOAD
 #undef PS_CPP_SRV_SER_OVERLOAD
 #undef PS_CPP_SRV_DES_OVERLOAD
 
@@ -0,0 +1,244 @@
+/*******************************************************************************
+ * @file    picostats.c
+ * @brief   Pico-ROS runtime statistics
+ * @date    2026-Oct-18
+ *
+ * @details Snapshots of lock-free entity counters and their periodic publishing
+ *          as statistics_msgs/MetricsMessage.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+/* Private includes ----------------------------------------------------------*/
+#include "picostats.h"
+#include "picoserdes.h"
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+ * @brief statistics_msgs/StatisticDataType values
+ */
+typedef enum {
+    STATISTICS_AVERAGE = 1,
+    STATISTICS_MINIMUM = 2,
+    STATISTICS_MAXIMUM = 3,
+    STATISTICS_STDDEV = 4,
+    STATISTICS_SAMPLE_COUNT = 5,
+} statistic_data_type_t;
+
+/* Private define ------------------------------------------------------------*/
+#define METRICS_TOPIC       "statistics"
+#define METRICS_BUF_SIZE    256u
+/* Private macro -------------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+static int64_t time_now_ns(void) {
+    _z_time_since_epoch t;
+    if (_z_get_time_since_epoch(&t) != Z_OK) {
+        return 0;
+    }
+    return (int64_t)t.secs * 1000000000 + t.nanos;
+}
+
+// Largest duration of callback histogram bucket
+static uint32_t callback_bucket_max(uint32_t bucket) {
+    if (bucket + 1 >= PICOROS_STATS_CB_BUCKETS) {
+        return UINT32_MAX;
+    }
+    return (1u << bucket) - 1u;
+}
+
+// Convert nanoseconds since epoch to builtin_interfaces/Time
+static ros_Time time_from_ns(int64_t ns) {
+    ros_Time t = {
+        .sec = (int32_t)(ns / 1000000000),
+        .nanosec = (uint32_t)(ns % 1000000000),
+    };
+    return t;
+}
+
+// Serialize and publish one MetricsMessage
+static picoros_res_t publish_metric(picoros_stats_reporter_t* rep, const char* source, const char* metric,
+                                    const char* unit, int64_t now, ros_StatisticDataPoint* points, uint32_t n_points) {
+    ros_MetricsMessage msg = {
+        .measurement_source_name = (rstring)source,
+        .metrics_source = (rstring)metric,
+        .unit = (rstring)unit,
+        .window_start = time_from_ns(rep->_window_start),
+        .window_stop = time_from_ns(now),
+        .statistics = {.data = points, .n_elements = n_points},
+    };
+    size_t len = ps_serialize(rep->buf, &msg, rep->buf_size);
+    return picoros_publish(&rep->pub, rep->buf, len);
+}
+
+// Publish metrics of entity for window and start next window
+static picoros_res_t report_entity(picoros_stats_reporter_t* rep, picoros_stats_entity_t* ent, int64_t now) {
+    picoros_stats_t cur;
+    picoros_stats_read(ent->stats, &cur);
+    picoros_stats_t* last = &ent->_last;
+    double window_s = (double)(now - rep->_window_start) / 1e9;
+    if (window_s <= 0) {
+        window_s = 1e-9;
+    }
+    uint32_t messages = cur.messages - last->messages;
+    uint32_t callbacks = cur.callbacks - last->callbacks;
+
+    // window maximum from histogram, cumulative maximum can be older
+    picoros_stats_t window = {0};
+    for (uint32_t i = 0; i < PICOROS_STATS_CB_BUCKETS; i++) {
+        window.callback_hist[i] = cur.callback_hist[i] - last->callback_hist[i];
+    }
+    window.callbacks = callbacks;
+
+    double callback_avg = callbacks ? (double)(cur.callback_us - last->callback_us) / callbacks : 0;
+    struct {
+        const char*            metric;
+        const char*            unit;
+        uint32_t               n_points;
+        ros_StatisticDataPoint points[3];
+    } metrics[] = {
+        {"message_rate", "msg/s", 2, {{STATISTICS_AVERAGE, messages / window_s},
+                                      {STATISTICS_SAMPLE_COUNT, messages}}},
+        {"byte_rate", "B/s", 1, {{STATISTICS_AVERAGE, (double)(cur.bytes - last->bytes) / window_s}}},
+        {"dropped", "count", 1, {{STATISTICS_SAMPLE_COUNT, cur.dropped - last->dropped}}},
+        {"allocations", "count", 1, {{STATISTICS_SAMPLE_COUNT, cur.allocations - last->allocations}}},
+        {"callback_duration", "us", 3, {{STATISTICS_AVERAGE, callback_avg},
+                                        {STATISTICS_MAXIMUM, picoros_stats_callback_percentile(&window, 100)},
+                                        {STATISTICS_SAMPLE_COUNT, callbacks}}},
+    };
+
+    picoros_res_t ret = PICOROS_OK;
+    for (uint32_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+        if (publish_metric(rep, ent->name, metrics[i].metric, metrics[i].unit, now,
+                           metrics[i].points, metrics[i].n_points) != PICOROS_OK) {
+            ret = PICOROS_ERROR;
+        }
+    }
+    *last = cur;
+    return ret;
+}
+
+#if Z_FEATURE_MULTI_THREAD == 1
+static void* report_task(void* arg) {
+    picoros_stats_reporter_t* rep = (picoros_stats_reporter_t*)arg;
+    while (__atomic_load_n(&rep->_running, __ATOMIC_ACQUIRE)) {
+        z_sleep_ms(rep->period_ms);
+        picoros_stats_report(rep);
+    }
+    return NULL;
+}
+#endif
+
+/* Public functions ----------------------------------------------------------*/
+
+void picoros_stats_read(const picoros_stats_t* stats, picoros_stats_t* out) {
+    out->messages = __atomic_load_n(&stats->messages, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&stats->bytes, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&stats->dropped, __ATOMIC_RELAXED);
+    out->allocations = __atomic_load_n(&stats->allocations, __ATOMIC_RELAXED);
+    out->callbacks = __atomic_load_n(&stats->callbacks, __ATOMIC_RELAXED);
+    out->callback_us = __atomic_load_n(&stats->callback_us, __ATOMIC_RELAXED);
+    out->callback_max_us = __atomic_load_n(&stats->callback_max_us, __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < PICOROS_STATS_CB_BUCKETS; i++) {
+        out->callback_hist[i] = __atomic_load_n(&stats->callback_hist[i], __ATOMIC_RELAXED);
+    }
+}
+
+void picoros_stats_reset(picoros_stats_t* stats) {
+    __atomic_store_n(&stats->messages, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->dropped, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->allocations, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->callbacks, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->callback_us, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->callback_max_us, 0, __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < PICOROS_STATS_CB_BUCKETS; i++) {
+        __atomic_store_n(&stats->callback_hist[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+uint32_t picoros_stats_callback_percentile(const picoros_stats_t* stats, double percentile) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < PICOROS_STATS_CB_BUCKETS; i++) {
+        total += __atomic_load_n(&stats->callback_hist[i], __ATOMIC_RELAXED);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(percentile / 100.0 * total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < PICOROS_STATS_CB_BUCKETS; i++) {
+        count += __atomic_load_n(&stats->callback_hist[i], __ATOMIC_RELAXED);
+        if (count >= rank) {
+            return callback_bucket_max(i);
+        }
+    }
+    return UINT32_MAX;
+}
+
+picoros_res_t picoros_stats_reporter_start(picoros_node_t* node, picoros_stats_reporter_t* reporter) {
+    if (node == NULL || reporter == NULL || (reporter->n_entities != 0 && reporter->entities == NULL)) {
+        return PICOROS_ERROR;
+    }
+    if (reporter->pub.topic.name == NULL) {
+        reporter->pub.topic.name = METRICS_TOPIC;
+    }
+    reporter->pub.topic.type = ROSTYPE_NAME(ros_MetricsMessage);
+    reporter->pub.topic.rihs_hash = ROSTYPE_HASH(ros_MetricsMessage);
+    if (reporter->buf == NULL) {
+        if (reporter->buf_size == 0) {
+            reporter->buf_size = METRICS_BUF_SIZE;
+        }
+        reporter->buf = z_malloc(reporter->buf_size);
+        if (reporter->buf == NULL) {
+            return PICOROS_ERROR;
+        }
+    }
+    if (picoros_publisher_declare(node, &reporter->pub) != PICOROS_OK) {
+        return PICOROS_ERROR;
+    }
+    for (uint8_t i = 0; i < reporter->n_entities; i++) {
+        picoros_stats_read(reporter->entities[i].stats, &reporter->entities[i]._last);
+    }
+    reporter->_window_start = time_now_ns();
+
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (reporter->period_ms != 0) {
+        reporter->_running = true;
+        if (z_task_init(&reporter->_task, NULL, report_task, reporter) != Z_OK) {
+            reporter->_running = false;
+            return PICOROS_ERROR;
+        }
+    }
+#endif
+    return PICOROS_OK;
+}
+
+picoros_res_t picoros_stats_report(picoros_stats_reporter_t* reporter) {
+    picoros_res_t ret = PICOROS_OK;
+    int64_t now = time_now_ns();
+    for (uint8_t i = 0; i < reporter->n_entities; i++) {
+        if (report_entity(reporter, &reporter->entities[i], now) != PICOROS_OK) {
+            ret = PICOROS_ERROR;
+        }
+    }
+    reporter->_window_start = now;
+    return ret;
+}
+
+void picoros_stats_reporter_stop(picoros_stats_reporter_t* reporter) {
+#if Z_FEATURE_MULTI_THREAD == 1
+    if (reporter->_running) {
+        __atomic_store_n(&reporter->_running, false, __ATOMIC_RELEASE);
+        z_task_join(z_task_move(&reporter->_task));
+    }
+#endif
+    picoros_publisher_undeclare(&reporter->pub);
+}
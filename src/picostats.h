@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * @file    picostats.h
+ * @brief   Pico-ROS runtime statistics
+ * @date    2026-Oct-18
+ *
+ * @details Reads picoros_stats_t counters of publishers, subscribers and service
+ *          servers and optionally publishes them periodically as
+ *          statistics_msgs/MetricsMessage.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#ifndef PICOSTATS_H_
+#define PICOSTATS_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+ /**
+ * @defgroup picostats picostats
+ * @{
+ */
+/** @} */
+
+/* Exported includes ---------------------------------------------------------*/
+#include "picoros.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief Entity reported by statistics reporter
+ * @ingroup picostats
+ */
+typedef struct {
+    const char*      name;      /**< Measurement source name, e.g. topic or service name */
+    picoros_stats_t* stats;     /**< Counters of entity */
+    picoros_stats_t  _last;     /**< Private counters at start of current window */
+} picoros_stats_entity_t;
+
+/**
+ * @brief Periodic publisher of entity statistics
+ * @details Each report window publishes message_rate, byte_rate, dropped, allocations
+ *          and callback_duration metrics of every entity as separate MetricsMessages,
+ *          like ROS topic statistics do. USER_TYPE_FILE has to list ros_Time,
+ *          ros_StatisticDataPoint and ros_MetricsMessage, see examples/example_types.h.
+ * @ingroup picostats
+ */
+typedef struct {
+    picoros_publisher_t     pub;        /**< Metrics publisher, topic name defaults to "statistics" */
+    picoros_stats_entity_t* entities;   /**< Reported entities */
+    uint8_t                 n_entities; /**< Number of entities */
+    uint32_t                period_ms;  /**< Report period, 0 to report only with picoros_stats_report() */
+    uint8_t*                buf;        /**< Serialization buffer, allocated at start if NULL */
+    size_t                  buf_size;   /**< Size of buf, default 256 bytes */
+    int64_t                 _window_start; /**< Private window start in nanoseconds since epoch */
+    bool                    _running;   /**< Private run flag */
+#if Z_FEATURE_MULTI_THREAD == 1
+    z_owned_task_t          _task;      /**< Private report task */
+#endif
+} picoros_stats_reporter_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Take consistent enough snapshot of entity counters
+ * @param stats Pointer to counters updated by picoros
+ * @param out Snapshot
+ * @ingroup picostats
+ */
+void picoros_stats_read(const picoros_stats_t* stats, picoros_stats_t* out);
+
+/**
+ * @brief Clear entity counters
+ * @param stats Pointer to counters
+ * @ingroup picostats
+ */
+void picoros_stats_reset(picoros_stats_t* stats);
+
+/**
+ * @brief Get callback duration percentile
+ * @param stats Pointer to counters or snapshot
+ * @param percentile Percentile from 0 to 100
+ * @return Upper bound of histogram bucket holding percentile in microseconds, 0 if no callbacks
+ * @ingroup picostats
+ */
+uint32_t picoros_stats_callback_percentile(const picoros_stats_t* stats, double percentile);
+
+/**
+ * @brief Declare metrics publisher and start periodic reporting
+ * @details Without multi-thread support picoros_stats_report() has to be called periodically.
+ * @param node Node publishing the metrics
+ * @param reporter Pointer to reporter configuration
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup picostats
+ */
+picoros_res_t picoros_stats_reporter_start(picoros_node_t* node, picoros_stats_reporter_t* reporter);
+
+/**
+ * @brief Publish metrics of all entities for window since last report
+ * @param reporter Pointer to started reporter
+ * @return PICOROS_OK on success, error code otherwise
+ * @ingroup picostats
+ */
+picoros_res_t picoros_stats_report(picoros_stats_reporter_t* reporter);
+
+/**
+ * @brief Stop periodic reporting and undeclare metrics publisher
+ * @param reporter Pointer to started reporter
+ * @ingroup picostats
+ */
+void picoros_stats_reporter_stop(picoros_stats_reporter_t* reporter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PICOSTATS_H_ */
@@ -0,0 +1,185 @@
+/*******************************************************************************
+ * @file    picotrace.c
+ * @brief   Pico-ROS tracing
+ * @date    2026-Oct-18
+ *
+ * @details Per-thread trace rings and their Chrome trace JSON export. Each ring
+ *          has a single writer, so recording is a timestamp read and a store.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+/* Private includes ----------------------------------------------------------*/
+#include <stdio.h>
+#include <inttypes.h>
+#include "zenoh-pico.h"
+#include "picotrace.h"
+#if defined(ZENOH_LINUX) || defined(ZENOH_MACOS)
+#include <time.h>
+#endif
+#if Z_FEATURE_MULTI_THREAD == 1 && (defined(ZENOH_LINUX) || defined(ZENOH_MACOS))
+#include <pthread.h>
+#define TRACE_RELEASE_RINGS 1
+#else
+#define TRACE_RELEASE_RINGS 0
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+ * @brief Trace ring of one thread
+ */
+typedef struct {
+    picotrace_record_t records[PICOTRACE_RING_RECORDS]; /**< Record storage */
+    uint32_t           head;                            /**< Number of written records */
+    bool               used;                            /**< Claimed by a running thread */
+} trace_ring_t;
+
+/* Private define ------------------------------------------------------------*/
+#if Z_FEATURE_MULTI_THREAD == 1
+    #define THREAD_LOCAL _Thread_local
+#else
+    #define THREAD_LOCAL
+#endif
+/* Private macro -------------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+static const char* const s_event_names[PICOTRACE_EV_USER] = {
+    [PICOTRACE_EV_PUBLISH] = "publish",
+    [PICOTRACE_EV_SAMPLE] = "sample",
+    [PICOTRACE_EV_CALLBACK] = "callback",
+    [PICOTRACE_EV_SERIALIZE] = "serialize",
+    [PICOTRACE_EV_DESERIALIZE] = "deserialize",
+    [PICOTRACE_EV_SRV_REQUEST] = "srv_request",
+    [PICOTRACE_EV_SRV_REPLY] = "srv_reply",
+};
+/* Private function prototypes -----------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static trace_ring_t s_rings[PICOTRACE_MAX_THREADS];
+static uint32_t s_untraced;
+static bool s_enabled = true;
+static THREAD_LOCAL trace_ring_t* t_ring;
+static THREAD_LOCAL bool t_claimed;
+#if !defined(ZENOH_LINUX) && !defined(ZENOH_MACOS)
+static z_clock_t s_epoch;
+#endif
+#if TRACE_RELEASE_RINGS
+static pthread_key_t s_ring_key;
+static pthread_once_t s_ring_key_once = PTHREAD_ONCE_INIT;
+#endif
+/* Private functions ---------------------------------------------------------*/
+
+static uint64_t trace_now_ns(void) {
+#if defined(ZENOH_LINUX) || defined(ZENOH_MACOS)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+    // zero epoch counts from platform clock start, microsecond resolution
+    return (uint64_t)z_clock_elapsed_us(&s_epoch) * 1000u;
+#endif
+}
+
+#if TRACE_RELEASE_RINGS
+// Free ring of exiting thread, its records are exported until the next owner overwrites them
+static void trace_ring_release(void* ring) {
+    __atomic_clear(&((trace_ring_t*)ring)->used, __ATOMIC_RELEASE);
+}
+
+static void trace_ring_key_create(void) {
+    pthread_key_create(&s_ring_key, trace_ring_release);
+}
+#endif
+
+// Claim free ring for calling thread, NULL if all rings are taken
+static trace_ring_t* trace_ring(void) {
+    if (!t_claimed) {
+        t_claimed = true;
+        for (uint32_t i = 0; i < PICOTRACE_MAX_THREADS && t_ring == NULL; i++) {
+            if (!__atomic_test_and_set(&s_rings[i].used, __ATOMIC_ACQUIRE)) {
+                t_ring = &s_rings[i];
+            }
+        }
+        if (t_ring == NULL) {
+            __atomic_fetch_add(&s_untraced, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+#if TRACE_RELEASE_RINGS
+        pthread_once(&s_ring_key_once, trace_ring_key_create);
+        pthread_setspecific(s_ring_key, t_ring);
+#endif
+    }
+    return t_ring;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void picotrace_record(uint16_t event, uint8_t phase, uint32_t arg) {
+    if (!__atomic_load_n(&s_enabled, __ATOMIC_RELAXED)) {
+        return;
+    }
+    trace_ring_t* ring = trace_ring();
+    if (ring == NULL) {
+        return;
+    }
+    uint32_t head = ring->head;
+    picotrace_record_t* rec = &ring->records[head & (PICOTRACE_RING_RECORDS - 1)];
+    rec->ts_ns = trace_now_ns();
+    rec->arg = arg;
+    rec->event = event;
+    rec->phase = phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void picotrace_enable(bool enable) {
+    __atomic_store_n(&s_enabled, enable, __ATOMIC_RELAXED);
+}
+
+void picotrace_clear(void) {
+    for (uint32_t i = 0; i < PICOTRACE_MAX_THREADS; i++) {
+        __atomic_store_n(&s_rings[i].head, 0, __ATOMIC_RELEASE);
+    }
+}
+
+size_t picotrace_dump(picotrace_write_cb_t write, void* ctx) {
+    char line[160];
+    size_t n_records = 0;
+    bool first_ring = true;
+
+    static const char header[] = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    write(header, sizeof(header) - 1, ctx);
+    for (uint32_t tid = 0; tid < PICOTRACE_MAX_THREADS; tid++) {
+        trace_ring_t* ring = &s_rings[tid];
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head == 0) {
+            continue;
+        }
+        int len = snprintf(line, sizeof(line),
+                           "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32
+                           ",\"args\":{\"name\":\"picoros-%" PRIu32 "\"}}",
+                           first_ring ? "" : ",", tid, tid);
+        write(line, (size_t)len, ctx);
+        first_ring = false;
+
+        uint32_t first = (head > PICOTRACE_RING_RECORDS) ? head - PICOTRACE_RING_RECORDS : 0;
+        for (uint32_t i = first; i != head; i++) {
+            const picotrace_record_t* rec = &ring->records[i & (PICOTRACE_RING_RECORDS - 1)];
+            char user_name[16];
+            const char* name = (rec->event < PICOTRACE_EV_USER) ? s_event_names[rec->event] : user_name;
+            if (rec->event >= PICOTRACE_EV_USER) {
+                snprintf(user_name, sizeof(user_name), "user%u", (unsigned)(rec->event - PICOTRACE_EV_USER));
+            }
+            len = snprintf(line, sizeof(line),
+                           ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03u,\"pid\":1,\"tid\":%" PRIu32
+                           "%s,\"args\":{\"arg\":%" PRIu32 "}}",
+                           name, rec->phase, rec->ts_ns / 1000u, (unsigned)(rec->ts_ns % 1000u), tid,
+                           rec->phase == PICOTRACE_PH_INSTANT ? ",\"s\":\"t\"" : "", rec->arg);
+            write(line, (size_t)len, ctx);
+            n_records++;
+        }
+    }
+    // threads that found no free ring
+    int len = snprintf(line, sizeof(line), "],\"otherData\":{\"untraced_threads\":%" PRIu32 "}}\n",
+                       __atomic_load_n(&s_untraced, __ATOMIC_RELAXED));
+    write(line, (size_t)len, ctx);
+    return n_records;
+}
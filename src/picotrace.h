@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * @file    picotrace.h
+ * @brief   Pico-ROS tracing
+ * @date    2026-Oct-18
+ *
+ * @details Tracepoints on the publish, receive, serdes and service paths write
+ *          fixed size records to per-thread lock-free ring buffers. Rings are
+ *          exported as Chrome trace JSON, which Perfetto and chrome://tracing
+ *          open directly. Tracepoints compile to nothing unless PICOROS_TRACE is 1.
+ *
+ * @copyright Copyright (c) 2025 Ubiquity Robotics
+ *******************************************************************************/
+
+#ifndef PICOTRACE_H_
+#define PICOTRACE_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+ /**
+ * @defgroup picotrace picotrace
+ * @{
+ */
+/** @} */
+
+/* Exported includes ---------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef PICOROS_TRACE
+/** @brief Flag to enable/disable tracepoints @ingroup picotrace */
+#define PICOROS_TRACE 0
+#endif
+#ifndef PICOTRACE_MAX_THREADS
+/** @brief Maximum number of traced threads, each gets its own ring @ingroup picotrace */
+#define PICOTRACE_MAX_THREADS 8u
+#endif
+#ifndef PICOTRACE_RING_RECORDS
+/** @brief Number of records in a ring, power of two @ingroup picotrace */
+#define PICOTRACE_RING_RECORDS 1024u
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief Traced events
+ * @ingroup picotrace
+ */
+typedef enum {
+    PICOTRACE_EV_PUBLISH = 0,       /**< z_publisher_put of a publication, arg is payload size */
+    PICOTRACE_EV_SAMPLE,            /**< Subscriber sample handling on read task, arg is payload size */
+    PICOTRACE_EV_CALLBACK,          /**< User callback */
+    PICOTRACE_EV_SERIALIZE,         /**< ps_serialize() */
+    PICOTRACE_EV_DESERIALIZE,       /**< ps_deserialize() and ps_deserialize_reader() */
+    PICOTRACE_EV_SRV_REQUEST,       /**< Service request handling on read task */
+    PICOTRACE_EV_SRV_REPLY,         /**< Service reply handling on read task */
+    PICOTRACE_EV_USER,              /**< First event number free for user tracepoints */
+} picotrace_event_t;
+
+/**
+ * @brief Record phase, values are Chrome trace phases
+ * @ingroup picotrace
+ */
+typedef enum {
+    PICOTRACE_PH_BEGIN = 'B',       /**< Start of duration */
+    PICOTRACE_PH_END = 'E',         /**< End of duration */
+    PICOTRACE_PH_INSTANT = 'i',     /**< Point in time */
+} picotrace_phase_t;
+
+/**
+ * @brief Trace record
+ * @ingroup picotrace
+ */
+typedef struct {
+    uint64_t ts_ns;                 /**< Monotonic time in nanoseconds */
+    uint32_t arg;                   /**< Event argument */
+    uint16_t event;                 /**< picotrace_event_t or user event */
+    uint8_t  phase;                 /**< picotrace_phase_t */
+    uint8_t  _reserved;             /**< Padding to 16 bytes */
+} picotrace_record_t;
+
+/**
+ * @brief Output function for trace export, e.g. wrapping fwrite or a UART driver
+ * @ingroup picotrace
+ */
+typedef void (*picotrace_write_cb_t)(const char* data, size_t len, void* ctx);
+
+/* Exported macro ------------------------------------------------------------*/
+#if PICOROS_TRACE == 1
+    #define PICOTRACE_BEGIN(event, arg)   picotrace_record((event), PICOTRACE_PH_BEGIN, (uint32_t)(arg))
+    #define PICOTRACE_END(event, arg)     picotrace_record((event), PICOTRACE_PH_END, (uint32_t)(arg))
+    #define PICOTRACE_INSTANT(event, arg) picotrace_record((event), PICOTRACE_PH_INSTANT, (uint32_t)(arg))
+#else
+    #define PICOTRACE_BEGIN(event, arg)   ((void)0)
+    #define PICOTRACE_END(event, arg)     ((void)0)
+    #define PICOTRACE_INSTANT(event, arg) ((void)0)
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Write trace record to ring of calling thread
+ * @details First record of a thread claims a free ring. Threads started when all PICOTRACE_MAX_THREADS
+ *          rings are claimed are not traced and counted as untraced_threads in the dump. With pthreads
+ *          the ring is freed on thread exit, otherwise rings stay claimed.
+ * @param event Event number
+ * @param phase Record phase
+ * @param arg Event argument
+ * @ingroup picotrace
+ */
+void picotrace_record(uint16_t event, uint8_t phase, uint32_t arg);
+
+/**
+ * @brief Enable or disable recording, enabled by default
+ * @param enable True to record
+ * @ingroup picotrace
+ */
+void picotrace_enable(bool enable);
+
+/**
+ * @brief Discard recorded records
+ * @details Recording should be disabled while clearing.
+ * @ingroup picotrace
+ */
+void picotrace_clear(void);
+
+/**
+ * @brief Export recorded rings as Chrome trace JSON
+ * @details Recording should be disabled while exporting, records written meanwhile can be torn.
+ *          Records of exited threads are exported until their ring is reused by another thread.
+ * @param write Output function called with consecutive pieces of JSON
+ * @param ctx Context given to write
+ * @return Number of exported records
+ * @ingroup picotrace
+ */
+size_t picotrace_dump(picotrace_write_cb_t write, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PICOTRACE_H_ */
@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * @file    test_picoalloc.c
+ * @brief   Tests for picoalloc accounting and strict guarded publishing
+ ******************************************************************************
+ */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../src/picoros.h"
+#include "../src/picoalloc.h"
+
+// Session listens on locator given as first argument, no router or remote peer is needed
+#define TEST_LOCATOR        "tcp/127.0.0.1:7451"
+#define TEST_PUBLISH_COUNT  100
+
+// Allowed steady state allocations per publish. zenoh-pico wraps payload and attachment
+// in reference counted slices, each allocating its control block.
+#ifndef TEST_PUBLISH_ALLOCS
+#define TEST_PUBLISH_ALLOCS 2
+#endif
+
+// Formatting constants
+#define TEST_INDENT "    "
+#define GREEN_TEXT "\033[0;32m"
+#define RED_TEXT   "\033[0;31m"
+#define RESET_TEXT "\033[0m"
+#define BOLD_TEXT  "\033[1m"
+
+static bool some_test_failed = false;
+static uint32_t violations;
+
+void print_test_result(const char* name, bool passed) {
+    printf("%s%s[%s] Test %s: %s%s\n",
+           TEST_INDENT,
+           passed ? GREEN_TEXT : RED_TEXT,
+           passed ? "✓" : "✗",
+           name,
+           passed ? "PASSED" : "FAILED",
+           RESET_TEXT);
+    if (!passed) {
+        some_test_failed = true;
+    }
+}
+
+// Count violations instead of aborting, report first call sites
+static void count_violation(const void* caller, size_t size) {
+    if (violations++ < 8) {
+        printf("%s  %zu byte allocation from %p\n", TEST_INDENT, size, caller);
+    }
+}
+
+// Live bytes follow wrapped allocations
+void test_accounting(void) {
+    picoalloc_stats_t start, mid, end;
+    picoalloc_read(&start);
+    uint8_t* p = z_malloc(100);
+    p = z_realloc(p, 300);
+    picoalloc_read(&mid);
+    z_free(p);
+    picoalloc_read(&end);
+    print_test_result("accounting", mid.live_bytes - start.live_bytes == 300
+                                    && end.live_bytes == start.live_bytes
+                                    && end.allocs - start.allocs == 2
+                                    && end.frees - start.frees == 1);
+}
+
+// Block allocated without wrapper is freed through z_free uncounted
+void test_foreign_free(void) {
+    picoalloc_stats_t start, end;
+    picoalloc_read(&start);
+    z_free(malloc(64));
+    picoalloc_read(&end);
+    print_test_result("foreign free", end.frees == start.frees && end.live_bytes == start.live_bytes);
+}
+
+// Strict region reports every allocation
+void test_strict_guard(void) {
+    violations = 0;
+    picoalloc_guard_begin(true);
+    void* p = z_malloc(16);
+    uint32_t allocs = picoalloc_guard_end();
+    z_free(p);
+    print_test_result("strict guard", allocs == 1 && violations == 1);
+}
+
+// Steady state publishing must stay within allocation budget
+void test_strict_publish(const char* locator) {
+    picoros_interface_t ifx = {
+        .mode = "peer",
+        .locator = (char*)locator,
+    };
+    picoros_node_t node = {
+        .name = "test_picoalloc",
+    };
+    picoros_publisher_t pub = {
+        .topic = {
+            .name = "picoros/test/alloc",
+        },
+    };
+    uint8_t payload[64] = {0};
+
+    if (picoros_interface_init(&ifx) != PICOROS_OK
+        || picoros_node_init(&node) != PICOROS_OK
+        || picoros_publisher_declare(&node, &pub) != PICOROS_OK) {
+        print_test_result("strict publish", false);
+        return;
+    }
+    // first publish may set up transport state
+    picoros_publish(&pub, payload, sizeof(payload));
+
+    violations = 0;
+    picoalloc_guard_begin(true);
+    picoros_publish(&pub, payload, sizeof(payload));
+    uint32_t single = picoalloc_guard_end();
+
+    violations = 0;
+    picoalloc_guard_begin(true);
+    for (uint32_t i = 0; i < TEST_PUBLISH_COUNT; i++) {
+        picoros_publish(&pub, payload, sizeof(payload));
+    }
+    uint32_t allocs = picoalloc_guard_end();
+    printf("%sAllocations per publish: %u, budget %u\n", TEST_INDENT, single, TEST_PUBLISH_ALLOCS);
+    print_test_result("strict publish", allocs == violations && single <= TEST_PUBLISH_ALLOCS
+                                        && allocs <= TEST_PUBLISH_ALLOCS * TEST_PUBLISH_COUNT);
+
+    picoros_publisher_undeclare(&pub);
+    picoros_interface_shutdown();
+}
+
+int main(int argc, char** argv) {
+    picoalloc_set_violation_cb(count_violation);
+
+    printf("%s  Allocation Accounting Tests:\n%s", BOLD_TEXT, RESET_TEXT);
+    test_accounting();
+    test_foreign_free();
+    test_strict_guard();
+    test_strict_publish((argc > 1) ? argv[1] : TEST_LOCATOR);
+
+    if (some_test_failed) {
+        printf("\n%s%s Some tests failed! %s\n\n", BOLD_TEXT, RED_TEXT, RESET_TEXT);
+        return EXIT_FAILURE;
+    }
+    printf("\n%s%s All tests completed successfully! %s\n\n", BOLD_TEXT, GREEN_TEXT, RESET_TEXT);
+    return EXIT_SUCCESS;
+}
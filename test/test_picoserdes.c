@@ -84,6 +84,56 @@ void print_test_result(const char* type_name, bool passed) {
         } \
     } while (0);
 
+/* Slice iterator splitting buffer into chunks of equal size */
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    size_t pos;
+    size_t chunk;
+} test_slices_t;
+
+bool test_slice_next(void* ctx, const uint8_t** data, size_t* len) {
+    test_slices_t* s = (test_slices_t*)ctx;
+    if (s->pos >= s->len) {
+        return false;
+    }
+    *data = s->data + s->pos;
+    *len = (s->len - s->pos < s->chunk) ? s->len - s->pos : s->chunk;
+    s->pos += *len;
+    return true;
+}
+
+/* Test macro for deserializing through fragmented buffer reader.
+ * Same as TEST_TYPE, but buffer1 is split to slices of every size from
+ * PS_READER_SEAM_SIZE to TEST_SLICE_MAX, so values and strings cross slice boundaries.
+ */
+#define TEST_SLICE_MAX 48
+#define TEST_TYPE_READER(type, ...) \
+    do { \
+        uint8_t buffer[TEST_BUFFER_SIZE] = {}; \
+        uint8_t buffer2[TEST_BUFFER_SIZE] = {}; \
+        type* original = &test_##type; \
+        size_t len = _ps_serialize(buffer, original, TEST_BUFFER_SIZE); \
+        bool test_passed = true; \
+        for (size_t chunk = PS_READER_SEAM_SIZE; chunk <= TEST_SLICE_MAX && test_passed; chunk++){ \
+            test_slices_t slices = {.data = buffer, .len = len, .chunk = chunk}; \
+            ps_reader_t reader; \
+            test_passed = ps_reader_init(&reader, test_slice_next, &slices) \
+                          && _ps_deserialize_reader(&reader, &deserialized_##type); \
+            memset(buffer2, 0, len); \
+            test_passed = test_passed \
+                          && _ps_serialize(buffer2, &deserialized_##type, TEST_BUFFER_SIZE) == len \
+                          && memcmp(buffer, buffer2, len) == 0; \
+            if(!test_passed){ \
+                printf("%sFailed with slices of %zu bytes\n", TEST_INDENT, chunk); \
+            } \
+        } \
+        print_test_result(#type " (sliced)", test_passed); \
+        if(!test_passed){ \
+            some_test_failed = true; \
+        } \
+    } while (0);
+
 /* Helper macros for test values generation */
 #define MAKE_TEST_SEQUENCE_DATA(TYPE, ...) \
     TYPE##_sequence test_sequence_##TYPE = {.data = &test_##TYPE, .n_elements = 1};
@@ -137,6 +187,9 @@ void print_test_result(const char* type_name, bool passed) {
 #define TEST_SRV(TYPE, ...) \
     TEST_TYPE(request_##TYPE) \
     TEST_TYPE(reply_##TYPE)
+#define TEST_SRV_READER(TYPE, ...) \
+    TEST_TYPE_READER(request_##TYPE) \
+    TEST_TYPE_READER(reply_##TYPE)
 
 
 int main() {
@@ -179,6 +232,11 @@ int main() {
     print_header("Service Types Tests:");
     SRV_LIST_EXPAND(TEST_SRV, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
 
+    print_header("Fragmented Reader Tests:");
+    BASE_TYPES_LIST_EXPAND(TEST_TYPE_READER)
+    MSG_LIST_EXPAND(PS_UNUSED, TEST_TYPE_READER, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+    SRV_LIST_EXPAND(TEST_SRV_READER, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED, PS_UNUSED)
+
     if(some_test_failed){
         printf("\n%s%s Some tests failed! %s\n\n",
                BOLD_TEXT, RED_TEXT, RESET_TEXT);